@@ -0,0 +1,183 @@
+#include "liblpf.h"
+#include "text.h"
+#include "workspace.h"
+#include "constants.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static inline void put_letter(void *out, SymbolType type, idx_t i, idx_t letter) {
+    switch (type) {
+        case SYM_U8:
+            ((uint8_t *)out)[i] = (uint8_t)letter;
+            break;
+        case SYM_U16:
+            ((uint16_t *)out)[i] = (uint16_t)letter;
+            break;
+        case SYM_U32:
+            ((uint32_t *)out)[i] = (uint32_t)letter;
+            break;
+        case SYM_IDX:
+        default:
+            ((idx_t *)out)[i] = letter;
+            break;
+    }
+}
+
+static int compare_letters(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Fibonacci hashing into a table of 2^bits slots
+static inline size_t letter_slot(uint64_t sym, int bits) {
+    return (size_t)((sym * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+/**
+* @brief Rank of every symbol value in [0, max] which occurs, by a histogram.
+*
+* @return Returns the ranks (indexed by the symbol), letters receives the
+*   distinct symbols in order and sigma their number.
+**/
+static idx_t *dense_ranks(const void *symbols, idx_t len, SymbolType type, uint64_t max, uint64_t *letters, idx_t *sigma) {
+    idx_t *rank = mem_calloc(max + 1, sizeof(idx_t));
+
+    for (idx_t i = 0; i < len; i++) {
+        rank[raw_symbol(symbols, type, i)] = 1;
+    }
+    idx_t next = 0;
+    for (uint64_t sym = 0; sym <= max; sym++) {
+        if (rank[sym]) {
+            letters[next] = sym;
+            rank[sym] = next++;
+        }
+    }
+    *sigma = next;
+    return rank;
+}
+
+/**
+* @brief Map a text onto the dense alphabet of the symbols it contains.
+*
+* The suffix array engines size their buckets by the alphabet bound, so
+* a text of token ids or 32-bit words (a few distinct values spread over
+* [0, 2^32)) would need buckets for every value up to the largest one,
+* or could not be described by a text in the 32-bit build at all. The
+* symbols are replaced by their rank among the distinct symbols, which
+* keeps the order and therefore every suffix array, LCP and LPF, and the
+* result has the narrowest type for its sigma letters.
+*
+* If the largest symbol is below ALPHABET_DENSE_MIN or ALPHABET_DENSE_FACTOR
+* times the length the ranks come from a histogram over the values.
+* Sparser alphabets are collected in a hash table of twice the length,
+* their sigma distinct values are sorted and looked up for every symbol.
+*
+* @param[in] symbols The symbols.
+* @param[in] len Number of symbols.
+* @param[in] type Width of the symbols.
+* @param[out] out Buffer for the letters, at least len symbols of the
+*   original width (it may be symbols itself). NULL to allocate it with
+*   mem_alloc, release it with mem_free and the length times the width
+*   of the result.
+* @param[out] map Receives the original symbol of every letter, NULL if
+*   it is not needed. Release it with cleanup_alphabet_map.
+*
+* @return Returns the text of the letters, its alphabet is sigma.
+**/
+text compact_alphabet(const void *symbols, idx_t len, SymbolType type, void *out, alphabet_map *map) {
+    uint64_t max = 0;
+    for (idx_t i = 0; i < len; i++) {
+        uint64_t sym = raw_symbol(symbols, type, i);
+        max = sym > max ? sym : max;
+    }
+
+    // At most len distinct symbols
+    uint64_t *letters = mem_alloc((len > 0 ? len : 1) * sizeof(uint64_t));
+    idx_t sigma;
+    SymbolType out_type;
+
+    if (max < ALPHABET_DENSE_MIN || max < (uint64_t)len * ALPHABET_DENSE_FACTOR) {
+        idx_t *rank = dense_ranks(symbols, len, type, max, letters, &sigma);
+        out_type = symbol_type_for(sigma);
+        if (out == NULL) {
+            out = mem_alloc((size_t)len * symbol_size(out_type));
+        }
+        // The letters are at most as wide as the symbols, letter i never overwrites an unread symbol
+        for (idx_t i = 0; i < len; i++) {
+            put_letter(out, out_type, i, rank[raw_symbol(symbols, type, i)]);
+        }
+        mem_free(rank, (max + 1) * sizeof(idx_t));
+    } else {
+        int bits = 4;
+        while (((size_t)1 << bits) < 2 * (size_t)len) {
+            bits++;
+        }
+        size_t slots = (size_t)1 << bits;
+        uint64_t *keys = mem_alloc(slots * sizeof(uint64_t));
+        idx_t *rank = mem_alloc(slots * sizeof(idx_t));
+        for (size_t s = 0; s < slots; s++) {
+            rank[s] = -1;
+        }
+
+        sigma = 0;
+        for (idx_t i = 0; i < len; i++) {
+            uint64_t sym = raw_symbol(symbols, type, i);
+            size_t s = letter_slot(sym, bits);
+            while (rank[s] >= 0 && keys[s] != sym) {
+                s = (s + 1) & (slots - 1);
+            }
+            if (rank[s] < 0) {
+                keys[s] = sym;
+                rank[s] = 0;
+                letters[sigma++] = sym;
+            }
+        }
+
+        qsort(letters, sigma, sizeof(uint64_t), compare_letters);
+        for (idx_t r = 0; r < sigma; r++) {
+            size_t s = letter_slot(letters[r], bits);
+            while (keys[s] != letters[r]) {
+                s = (s + 1) & (slots - 1);
+            }
+            rank[s] = r;
+        }
+
+        out_type = symbol_type_for(sigma);
+        if (out == NULL) {
+            out = mem_alloc((size_t)len * symbol_size(out_type));
+        }
+        for (idx_t i = 0; i < len; i++) {
+            uint64_t sym = raw_symbol(symbols, type, i);
+            size_t s = letter_slot(sym, bits);
+            while (keys[s] != sym) {
+                s = (s + 1) & (slots - 1);
+            }
+            put_letter(out, out_type, i, rank[s]);
+        }
+        mem_free(keys, slots * sizeof(uint64_t));
+        mem_free(rank, slots * sizeof(idx_t));
+    }
+
+    if (map != NULL) {
+        map->letters = mem_alloc((sigma > 0 ? sigma : 1) * sizeof(uint64_t));
+        memcpy(map->letters, letters, sigma * sizeof(uint64_t));
+        map->size = sigma;
+        map->type = type;
+    }
+    mem_free(letters, (len > 0 ? len : 1) * sizeof(uint64_t));
+    return text_init(out, len, out_type, sigma > 0 ? sigma : 1);
+}
+
+/**
+* @brief The original symbol of a letter of a compacted text.
+**/
+uint64_t alphabet_letter(const alphabet_map *map, idx_t letter) {
+    return map->letters[letter];
+}
+
+void cleanup_alphabet_map(alphabet_map *map) {
+    mem_free(map->letters, (map->size > 0 ? map->size : 1) * sizeof(uint64_t));
+    map->letters = NULL;
+    map->size = 0;
+}
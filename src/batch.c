@@ -0,0 +1,252 @@
+#include "batch.h"
+#include "input.h"
+#include "liblpf.h"
+#include "parallel.h"
+#include "text.h"
+#include "util.h"
+#include "lpf.h"
+#include "suffix_array.h"
+#include "constants.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+struct record {
+    size_t offset;      // Of the first symbol in the input
+    idx_t len;
+};
+typedef struct record record;
+
+struct batch_job {
+    Algorithm alg;
+    const uint8_t *data;
+    const record *records;
+    idx_t first;        // The block is records[first...end-1]
+    idx_t end;
+    const size_t *out;  // Offset of every record of the block in results
+    idx_t *results;
+    idx_t next;         // The next record to take
+    lpf_context *ctx[MAX_THREADS];
+};
+typedef struct batch_job batch_job;
+
+static void truncated_record(size_t offset) {
+    fprintf(stderr, "Truncated record at byte %zu\n", offset);
+    exit(1);
+}
+
+// Splits the input into records, *count is set to their number
+static record *split_records(const uint8_t *data, size_t size, RecordFormat format, idx_t *count) {
+    size_t cap = 1024, n = 0, pos = 0;
+    record *records = malloc(cap * sizeof(record));
+
+    while (pos < size) {
+        size_t len;
+        if (format == RECORDS_PREFIXED) {
+            if (size - pos < 4) {
+                truncated_record(pos);
+            }
+            len = data[pos] | (size_t)data[pos+1] << 8 | (size_t)data[pos+2] << 16 | (size_t)data[pos+3] << 24;
+            pos += 4;
+            if (size - pos < len) {
+                truncated_record(pos - 4);
+            }
+        } else {
+            const uint8_t *nl = memchr(data + pos, '\n', size - pos);
+            len = nl != NULL ? (size_t)(nl - data) - pos : size - pos;
+        }
+        if (len >= (size_t)IDX_MAX) {
+            fprintf(stderr, "Record at byte %zu is too long for %d-bit indices\n", pos, INDEX_BITS);
+            exit(1);
+        }
+
+        if (n == cap) {
+            cap *= 2;
+            records = realloc(records, cap * sizeof(record));
+        }
+        if (records == NULL) {
+            perror("Error allocating records");
+            exit(1);
+        }
+        records[n].offset = pos;
+        records[n].len = (idx_t)len;
+        n++;
+        pos += len + (format == RECORDS_LINES);
+    }
+    *count = (idx_t)n;
+    return records;
+}
+
+// Workers take BATCH_GRAB records at a time, every worker has its own context
+static void batch_task(void *arg, int id, int chunks) {
+    batch_job *job = arg;
+    lpf_context *ctx = job->ctx[id];
+    (void)chunks;
+
+    for (;;) {
+        idx_t r = __atomic_fetch_add(&job->next, BATCH_GRAB, __ATOMIC_RELAXED);
+        if (r >= job->end) {
+            return;
+        }
+        idx_t last = r + BATCH_GRAB < job->end ? r + BATCH_GRAB : job->end;
+
+        for (; r < last; r++) {
+            const record *rec = &job->records[r];
+            // The alphabet of the record, not of all bytes, sizes the buckets
+            text t = text_init(job->data + rec->offset, rec->len, SYM_U8, 0);
+            idx_t *out = job->results + job->out[r - job->first];
+            if (job->alg == SUFFIX_ARRAY) {
+                lpf_context_suffix_array(ctx, &t, out);
+            } else {
+                lpf_context_lpf(ctx, &t, out, NULL);
+            }
+        }
+    }
+}
+
+// One line of space separated numbers, formatted by hand since printf dominates otherwise
+static void write_index_line(FILE *file, const idx_t *arr, idx_t len) {
+    char buf[4096];
+    size_t used = 0;
+    for (idx_t i = 0; i < len; i++) {
+        char digits[24];
+        int d = 0;
+        long long v = arr[i];
+        if (v < 0) {
+            buf[used++] = '-';
+            v = -v;
+        }
+        do {
+            digits[d++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v > 0);
+        while (d > 0) {
+            buf[used++] = digits[--d];
+        }
+        buf[used++] = i + 1 < len ? ' ' : '\n';
+        if (used > sizeof(buf) - 32) {
+            fwrite(buf, 1, used, file);
+            used = 0;
+        }
+    }
+    if (len == 0) {
+        buf[used++] = '\n';
+    }
+    fwrite(buf, 1, used, file);
+}
+
+/**
+* @brief Compute the suffix array or the LPF array of every record of a file.
+*
+* The records (lines or length-prefixed, see RecordFormat) are processed
+* in blocks of up to BATCH_RECORDS records or BATCH_SYMBOLS symbols.
+* Every thread of set_thread_count takes records of the block until none
+* are left, with its own context (liblpf.h) whose workspace is kept for
+* all records, so a short record costs no allocation. The arrays are
+* written in input order, one line of numbers per record. The throughput
+* is printed at the end.
+*
+* @param[in] alg SUFFIX_ARRAY or LPF.
+* @param[in] input The records file.
+* @param[in] format The framing of the records.
+* @param[in] output The file for the arrays.
+**/
+void batch_run(Algorithm alg, const char *input, RecordFormat format, const char *output) {
+    input_file in;
+    text file = map_input_file(&in, input, SYM_U8);
+    FILE *out = fopen(output, "w");
+    if (out == NULL) {
+        perror("Error opening output file");
+        exit(1);
+    }
+
+    double start = wall_time(), busy = 0;
+    idx_t count;
+    record *records = split_records(file.symbols, in.size, format, &count);
+    int workers = get_thread_count();
+    size_t *offsets = malloc((BATCH_RECORDS + 1) * sizeof(size_t));
+    size_t results_cap = BATCH_SYMBOLS;
+    batch_job job;
+
+    job.alg = alg;
+    job.data = file.symbols;
+    job.records = records;
+    job.results = malloc(results_cap * sizeof(idx_t));
+    for (int w = 0; w < workers; w++) {
+        job.ctx[w] = lpf_context_create(get_sa_engine(), get_lpf_algorithm(), 1);
+    }
+
+    long long symbols = 0;
+    for (idx_t first = 0; first < count;) {
+        // A block ends before BATCH_SYMBOLS unless its first record alone is longer
+        idx_t end = first;
+        size_t total = 0;
+        while (end < count && end - first < BATCH_RECORDS && (end == first || total + records[end].len <= BATCH_SYMBOLS)) {
+            offsets[end - first] = total;
+            total += records[end].len;
+            end++;
+        }
+        if (total > results_cap) {
+            results_cap = total;
+            free(job.results);
+            job.results = malloc(results_cap * sizeof(idx_t));
+        }
+        if (job.results == NULL || offsets == NULL) {
+            perror("Error allocating batch results");
+            exit(1);
+        }
+
+        job.first = first;
+        job.end = end;
+        job.out = offsets;
+        job.next = first;
+        double block_start = wall_time();
+        parallel_run(batch_task, &job, workers);
+        busy += wall_time() - block_start;
+
+        for (idx_t r = first; r < end; r++) {
+            write_index_line(out, job.results + offsets[r - first], records[r].len);
+        }
+        symbols += total;
+        first = end;
+    }
+
+    if (fclose(out) != 0) {
+        perror("Error writing output file");
+        exit(1);
+    }
+    double seconds = wall_time() - start;
+    printf("Records: %" PRIdx " (%lld symbols, %s) on %d threads\n", count, symbols, record_format_name(format), workers);
+    printf("Time: %f seconds (%f computing), %.0f records/s, %.2f MB/s\n", seconds, busy, seconds > 0 ? count / seconds : 0.0, seconds > 0 ? symbols / seconds / 1e6 : 0.0);
+    printf("Computing only: %.0f records/s\n", busy > 0 ? count / busy : 0.0);
+
+    for (int w = 0; w < workers; w++) {
+        lpf_context_free(job.ctx[w]);
+    }
+    free(job.results);
+    free(offsets);
+    free(records);
+    close_input(&in);
+}
+
+const char *record_format_name(RecordFormat format) {
+    return format == RECORDS_PREFIXED ? "prefixed" : "lines";
+}
+
+/**
+* @brief Parse the framing of the batch records ("lines" or "prefixed").
+*
+* @return Returns 1 if the format was recognized, 0 otherwise.
+**/
+int parse_record_format(const char *name, RecordFormat *format) {
+    if (!strcmp(name, "lines")) {
+        *format = RECORDS_LINES;
+        return 1;
+    }
+    if (!strcmp(name, "prefixed")) {
+        *format = RECORDS_PREFIXED;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+#include "constants.h"
+
+#ifndef BATCH_H
+#define BATCH_H
+
+void batch_run(Algorithm alg, const char *input, RecordFormat format, const char *output);
+const char *record_format_name(RecordFormat format);
+int parse_record_format(const char *name, RecordFormat *format);
+
+#endif
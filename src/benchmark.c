@@ -1,7 +1,16 @@
+#include "lz.h"
 #include "lpf.h"
+#include "liblpf.h"
+#include "lcp.h"
+#include "text.h"
+#include "mismatch.h"
 #include "util.h"
+#include "perf.h"
+#include "phase.h"
 #include "tuple.h"
 #include "benchmark.h"
+#include "corpus.h"
+#include "workspace.h"
 #include "constants.h"
 #include "suffix_array.h"
 #include "suffix_array_qsort.h"
@@ -10,178 +19,764 @@
 #include <stdio.h>
 #include <time.h>
 #include <string.h>
+#include <math.h>
 
-void validate_lpf(int str_len, int tries, int asize) {
-    printf("Validating lpf arrays %d times with random strings[1...%d], |∑| = %d\n", tries, str_len, asize); 
-    int *str = malloc((str_len + ADDITIONAL_PADDING) * sizeof(int));
-    str = random_str(str, str_len, asize);
-    int *lpf1, *lpf2;
+static int warmup_runs = 1;
+static int sweep_points = 1;
+static double sweep_growth = 2;
+static int run_naive = 1;
+static unsigned int benchmark_seed = 1;
+static int read_counters = 0;
+static idx_t stream_chunk = STREAM_CHUNK;
+
+struct run_stats {
+    double mean;
+    double median;
+    double p95;
+    double stddev;
+};
+typedef struct run_stats run_stats;
+
+static int compare_doubles(const void *a, const void *b);
+
+// Returns the first i where the PHI and the succinct LCP differ from Kasai, -1 if none
+static idx_t check_lcp(const text *t, idx_t *sa) {
+    idx_t *sar = reverse_array(sa, t->len);
+    idx_t *lcp = lcp_array(t, sa, sar);
+    idx_t *plcp = plcp_array(t, sa);
+    succinct_plcp *compact = succinct_plcp_create(t, sa);
+    idx_t bad = -1;
+
+    for (idx_t i = 1; i < t->len && bad < 0; i++) {
+        if (plcp[sa[i]] != lcp[i] || succinct_lcp_get(compact, sa, i) != lcp[i]) {
+            bad = i;
+        }
+    }
+    mem_free(sar, t->len * sizeof(idx_t));
+    mem_free(lcp, t->len * sizeof(idx_t));
+    mem_free(plcp, t->len * sizeof(idx_t));
+    cleanup_succinct_plcp(compact);
+    return bad;
+}
+
+// Returns the first i where PrevOcc[i] is not an earlier occurrence of the factor, -1 if none
+static idx_t check_prev_occ(const text *t, idx_t *lpf, idx_t *prev_occ) {
+    for (idx_t i = 0; i < t->len; i++) {
+        idx_t j = prev_occ[i];
+        if (lpf[i] == 0) {
+            if (j != -1) {
+                return i;
+            }
+            continue;
+        }
+        if (j < 0 || j >= i) {
+            return i;
+        }
+        for (idx_t k = 0; k < lpf[i]; k++) {
+            if (text_symbol(t, j+k) != text_symbol(t, i+k)) {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+void validate_lpf(StrType str_type, idx_t str_len, int tries, int asize) {
+    printf("Validating lpf arrays (%s, %s) %d times with %s strings[1...%" PRIdx "], |∑| = %d\n", lpf_algorithm_name(get_lpf_algorithm()), sa_engine_name(get_sa_engine()), tries, str_type_name(str_type), str_len, asize); 
+    void *str = NULL;
+    idx_t *lpf1, *lpf2, *prev_occ;
    
     for (int i = 0; i < tries; i++) {
-        lpf1 = lpf_array(str, str_len);
-        lpf2 = lpf_array_naive(str, str_len);
-        for (int k = 0; k < str_len; k++) {
-            if (memcmp(lpf1, lpf2, str_len * sizeof(int))) {
+        text t = generate_text(&str, str_type, str_len, &asize);
+        lpf1 = lpf_array_prev(&t, &prev_occ);
+        lpf2 = lpf_array_naive(&t);
+        idx_t bad_prev = check_prev_occ(&t, lpf1, prev_occ);
+        if (memcmp(lpf1, lpf2, t.len * sizeof(idx_t)) || bad_prev >= 0) {
+            if (bad_prev >= 0) {
+                printf("WRONG PREVIOUS OCCURRENCE AT %" PRIdx "\n", bad_prev);
+            } else {
+                printf("FOUND DIFFERENT LPF ARRAYS\n");
+            }
+            print_text(&t, 0, t.len, NULL);
+            print_lpf_array(&t, lpf1, prev_occ);
+            printf("\n");
+            print_lpf_array(&t, lpf2, NULL);
+            
+            free(str);            
+            mem_free(lpf1, t.len * sizeof(idx_t));
+            mem_free(lpf2, t.len * sizeof(idx_t));        
+            mem_free(prev_occ, t.len * sizeof(idx_t));
+            return;
+        }
+        mem_free(lpf1, t.len * sizeof(idx_t));
+        mem_free(lpf2, t.len * sizeof(idx_t));
+        mem_free(prev_occ, t.len * sizeof(idx_t));
+    }
+    free(str);
+    printf("SUCCESS!\n");
+}
+
+/**
+* @brief Validate the streaming LPF against the naive one.
+*
+* The text is appended in chunks of random lengths and the final values
+* are read in random amounts after every chunk.
+**/
+void validate_stream(StrType str_type, idx_t str_len, int tries, int asize) {
+    printf("Validating streamed lpf arrays %d times with %s strings[1...%" PRIdx "], |∑| = %d\n", tries, str_type_name(str_type), str_len, asize); 
+    void *str = NULL;
+
+    for (int i = 0; i < tries; i++) {
+        text t = generate_text(&str, str_type, str_len, &asize);
+        idx_t *lpf1 = mem_alloc(t.len * sizeof(idx_t));
+        idx_t *prev_occ = mem_alloc(t.len * sizeof(idx_t));
+        lpf_stream *s = lpf_stream_create(t.type);
+        idx_t done = 0, read = 0;
+
+        while (done < t.len) {
+            idx_t chunk = 1 + rand() % (rand() % 2 ? 8 : t.len);
+            chunk = chunk < t.len - done ? chunk : t.len - done;
+            lpf_stream_append(s, (const char *)t.symbols + (size_t)done * symbol_size(t.type), chunk);
+            done += chunk;
+            if (read < t.len) {
+                read += lpf_stream_read(s, lpf1 + read, prev_occ + read, 1 + rand() % (t.len - read));
+            }
+        }
+        lpf_stream_finish(s);
+        read += lpf_stream_read(s, lpf1 + read, prev_occ + read, t.len - read);
+        lpf_stream_free(s);
+
+        idx_t *lpf2 = lpf_array_naive(&t);
+        idx_t bad_prev = read == t.len ? check_prev_occ(&t, lpf1, prev_occ) : 0;
+        if (read != t.len || memcmp(lpf1, lpf2, t.len * sizeof(idx_t)) || bad_prev >= 0) {
+            if (read != t.len) {
+                printf("STREAM RETURNED %" PRIdx " OF %" PRIdx " VALUES\n", read, t.len);
+            } else if (bad_prev >= 0) {
+                printf("WRONG PREVIOUS OCCURRENCE AT %" PRIdx "\n", bad_prev);
+            } else {
                 printf("FOUND DIFFERENT LPF ARRAYS\n");
-                printf_array(str, str_len);
-                print_lpf_array(str, lpf1, str_len);
+            }
+            print_text(&t, 0, t.len, NULL);
+            if (read == t.len) {
+                print_lpf_array(&t, lpf1, prev_occ);
                 printf("\n");
-                print_lpf_array(str, lpf2, str_len);
-                
-                free(str);            
-                free(lpf1);
-                free(lpf2);        
-                return;
             }
+            print_lpf_array(&t, lpf2, NULL);
+
+            free(str);
+            mem_free(lpf1, t.len * sizeof(idx_t));
+            mem_free(lpf2, t.len * sizeof(idx_t));
+            mem_free(prev_occ, t.len * sizeof(idx_t));
+            return;
         }
-        free(lpf1);
-        free(lpf2);
+        mem_free(lpf1, t.len * sizeof(idx_t));
+        mem_free(lpf2, t.len * sizeof(idx_t));
+        mem_free(prev_occ, t.len * sizeof(idx_t));
     }
     free(str);
     printf("SUCCESS!\n");
 }
 
-void validate_suffix_array(int str_len, int tries, int asize) {
-    printf("Validating suffix arrays %d times with random strings[1...%d], |∑| = %d\n", tries, str_len, asize); 
-    int *sa1, *sa2;
-    int *str = malloc((str_len + ADDITIONAL_PADDING) * sizeof(int));
+void validate_suffix_array(StrType str_type, idx_t str_len, int tries, int asize) {
+    printf("Validating suffix arrays (%s) %d times with %s strings[1...%" PRIdx "], |∑| = %d\n", sa_engine_name(get_sa_engine()), tries, str_type_name(str_type), str_len, asize); 
+    idx_t *sa1, *sa2;
+    void *str = NULL;
 
     for (int i = 0; i < tries; i++) {
-        str = random_str(str, str_len, asize);
-        sa1 = suffix_array(str, str_len);
-        sa2 = suffix_array_qsort(str, str_len);
+        text t = generate_text(&str, str_type, str_len, &asize);
+        sa1 = suffix_array_engine(&t);
+        sa2 = suffix_array_qsort(&t);
         int bug = 0;
-        for (int k = 0; k < str_len; k++) {
+        for (idx_t k = 0; k < t.len; k++) {
             if (sa1[k] != sa2[k]) {
-                printf("BUG: Suffix array differ! %d\n", k);
-                fwrite(str + sa1[k],  sizeof(int), str_len - sa1[k],stdout);
-                printf("\n");
-                fwrite(str + sa2[k],  sizeof(int), str_len - sa2[k],stdout);
-                printf("\n");
+                printf("BUG: Suffix array differ! %" PRIdx "\n", k);
+                print_text(&t, sa1[k], t.len - sa1[k], NULL);
+                print_text(&t, sa2[k], t.len - sa2[k], NULL);
                 bug = 1; 
             }
         }
+        idx_t bad_lcp = bug ? -1 : check_lcp(&t, sa1);
+        if (bad_lcp >= 0) {
+            printf("BUG: LCP differ! %" PRIdx "\n", bad_lcp);
+            bug = 1;
+        }
         if (bug) {
-            printf_array(str, str_len);
+            print_text(&t, 0, t.len, NULL);
         // print_suffix_array(str, sa1, str_len);
         // printf("\n");
         // print_suffix_array(str, sa2, str_len);
-            free(sa1);
-            free(sa2);
+            mem_free(sa1, t.len * sizeof(idx_t));
+            mem_free(sa2, t.len * sizeof(idx_t));
             free(str);   
             return;
         }
-        free(sa1);
-        free(sa2);
+        mem_free(sa1, t.len * sizeof(idx_t));
+        mem_free(sa2, t.len * sizeof(idx_t));
     }
     free(str);   
     printf("SUCCESS!\n");
 }
 
-void benchmark_runner(Algorithm alg, StrType str_type, int str_len, int tries, int asize) {
-    int *(*f)(int*, int);
-    int *(*f_naive)(int*, int);
-    FILE *file;
+/**
+* @brief Number of untimed runs on the first input of every data point.
+**/
+void set_benchmark_warmup(int runs) {
+    warmup_runs = runs < 0 ? 0 : runs;
+}
+
+/**
+* @brief Benchmark points sizes, each growth times the previous one.
+*
+* For Fibonacci words the index grows by one per point, the length
+* grows by the golden ratio then.
+**/
+void set_benchmark_sweep(int points, double growth) {
+    sweep_points = points < 1 ? 1 : points;
+    sweep_growth = growth > 1 ? growth : 2;
+}
+
+/**
+* @brief Symbols per append of the stream benchmark.
+**/
+void set_benchmark_chunk(idx_t chunk) {
+    stream_chunk = chunk < 1 ? 1 : chunk;
+}
+
+void set_benchmark_naive(int naive) {
+    run_naive = naive;
+}
+
+/**
+* @brief Read the hardware counters (perf.h) around every timed run and phase.
+**/
+void set_benchmark_counters(int counters) {
+    read_counters = counters;
+}
+
+/**
+* @brief Run i of every data point uses the random text of srand(seed + i).
+**/
+void set_benchmark_seed(unsigned int seed) {
+    benchmark_seed = seed;
+}
+
+// Median, 95th percentile (nearest rank) and standard deviation of n run times
+static run_stats summarize(const double *times, int n) {
+    run_stats st = {0, 0, 0, 0};
+    if (n <= 0) {
+        return st;
+    }
+
+    double *sorted = malloc((size_t)n * sizeof(double));
+    memcpy(sorted, times, (size_t)n * sizeof(double));
+    qsort(sorted, n, sizeof(double), compare_doubles);
+
+    for (int i = 0; i < n; i++) {
+        st.mean += sorted[i];
+    }
+    st.mean /= n;
+    st.median = n % 2 ? sorted[n/2] : (sorted[n/2-1] + sorted[n/2]) / 2;
+    st.p95 = sorted[(95 * n + 99) / 100 - 1];
+    for (int i = 0; i < n; i++) {
+        st.stddev += (sorted[i] - st.mean) * (sorted[i] - st.mean);
+    }
+    st.stddev = n > 1 ? sqrt(st.stddev / (n - 1)) : 0;
+
+    free(sorted);
+    return st;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_run_stats(const char *name, const run_stats *st, int runs) {
+    printf("%s: %lld ns per call (%f seconds), median %lld ns, p95 %lld ns, sd %lld ns, total: %f seconds\n", name, SEC_TO_NANO(st->mean), st->mean, SEC_TO_NANO(st->median), SEC_TO_NANO(st->p95), SEC_TO_NANO(st->stddev), st->mean * runs);
+}
+
+// The columns every benchmark row shares, ALG and NALG are set by the caller
+static void fill_row(long long *row, idx_t len, StrType str_type, int tries, int asize, int run) {
+    row[0] = len;
+    row[1] = str_type;
+    row[2] = tries;
+    row[3] = asize;
+    row[6] = get_sa_engine();
+    row[7] = INDEX_BITS;
+    row[8] = get_lpf_algorithm();
+    row[9] = run;
+    row[10] = str_type == FIBONACCI || str_type == THUE_MORSE || str_type == PERIOD_DOUBLING ? -1 : (long long)benchmark_seed + run;
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        row[11 + e] = -1;
+    }
+}
+
+static void set_row_counters(long long *row, const perf_sample *counters) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        row[11 + e] = counters->values[e];
+    }
+}
+
+static void add_counters(perf_sample *sum, const perf_sample *s) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        sum->values[e] = s->values[e] < 0 ? -1 : sum->values[e] + s->values[e];
+    }
+}
+
+// Prints the counters per symbol, summed over runs texts of len symbols
+static void print_counters(const char *name, const perf_sample *s, int runs, idx_t len) {
+    double symbols = (double)runs * (len > 0 ? len : 1);
+
+    printf("%s:", name);
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (s->values[e] >= 0) {
+            printf(" %s %.2f", perf_event_name(e), s->values[e] / symbols);
+        }
+    }
+    if (s->values[0] > 0 && s->values[1] >= 0) {
+        printf(" (IPC %.2f)", (double)s->values[1] / s->values[0]);
+    }
+    printf(" per symbol\n");
+}
+
+// The counters of Alg1 and of each phase which ran
+static void print_run_counters(const perf_sample *total, const phase_stats *phases, int runs, idx_t len) {
+    print_counters("Counters", total, runs, len);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        if (phases->calls[p] > 0) {
+            char name[32];
+            snprintf(name, sizeof(name), "  %s", phase_name(p));
+            print_counters(name, &phases->counters[p], runs, len);
+        }
+    }
+}
+
+static void add_phase_stats(phase_stats *sum, const phase_stats *s) {
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        sum->seconds[p] += s->seconds[p];
+        sum->calls[p] += s->calls[p];
+        add_counters(&sum->counters[p], &s->counters[p]);
+    }
+    for (int d = 0; d < PHASE_MAX_DEPTH; d++) {
+        sum->depth_seconds[d] += s->depth_seconds[d];
+    }
+    sum->max_depth = s->max_depth > sum->max_depth ? s->max_depth : sum->max_depth;
+
+    // The memory is the highest of all runs
+    sum->peak_bytes = s->peak_bytes > sum->peak_bytes ? s->peak_bytes : sum->peak_bytes;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        sum->phase_peak_bytes[p] = s->phase_peak_bytes[p] > sum->phase_peak_bytes[p] ? s->phase_peak_bytes[p] : sum->phase_peak_bytes[p];
+    }
+    for (int d = 0; d < PHASE_MAX_DEPTH; d++) {
+        sum->depth_peak_bytes[d] = s->depth_peak_bytes[d] > sum->depth_peak_bytes[d] ? s->depth_peak_bytes[d] : sum->depth_peak_bytes[d];
+    }
+}
+
+// Milliseconds per run and peak bytes per symbol of each phase which ran and of every recursion level
+static void print_phase_times(const phase_stats *phases, int runs, idx_t len) {
+    double symbols = len > 0 ? len : 1;
+    if (runs <= 0) {
+        return;
+    }
+    printf("Phases (ms per run):");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        if (phases->calls[p] > 0) {
+            printf(" %s %.3f (%lld calls)", phase_name(p), phases->seconds[p] * 1e3 / runs, phases->calls[p] / runs);
+        }
+    }
+    printf("\nPeak memory (bytes per symbol): %.2f, by phase:", phases->peak_bytes / symbols);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        if (phases->calls[p] > 0) {
+            printf(" %s %.2f", phase_name(p), phases->phase_peak_bytes[p] / symbols);
+        }
+    }
+    printf("\n");
+    for (int d = 1; d <= phases->max_depth && d < PHASE_MAX_DEPTH; d++) {
+        printf("  recursion depth %d: %.3f ms, %.2f bytes per symbol\n", d, phases->depth_seconds[d] * 1e3 / runs, phases->depth_peak_bytes[d] / symbols);
+    }
+}
+
+static text benchmark_text(void **str, StrType str_type, idx_t str_len, int *asize, int run);
+
+// The mean and the longest LCP of the text of run 0, the repetitiveness the kernels see
+static void print_lcp_profile(StrType str_type, idx_t str_len, int asize) {
+    void *str = NULL;
+    text t = benchmark_text(&str, str_type, str_len, &asize, 0);
+    idx_t *sa = suffix_array_engine(&t);
+    idx_t *plcp = plcp_array(&t, sa);
+    double sum = 0;
+    idx_t max = 0;
+
+    for (idx_t i = 0; i < t.len; i++) {
+        sum += plcp[i];
+        max = plcp[i] > max ? plcp[i] : max;
+    }
+    printf("Text (%s, |∑| = %d): mean LCP %.2f, max LCP %" PRIdx "\n", str_type_name(str_type), asize, t.len > 0 ? sum / t.len : 0.0, max);
+    mem_free(sa, t.len * sizeof(idx_t));
+    mem_free(plcp, t.len * sizeof(idx_t));
+    free(str);
+}
+
+/**
+* @brief Benchmark alg on sweep_points input sizes and append one CSV row per run.
+*
+* Every data point runs warmup_runs untimed calls and tries timed calls
+* on the texts of the seeds benchmark_seed + run. The rows are written
+* to the results file of the algorithm once all points are done.
+*
+* @param[in] alg The algorithm.
+* @param[in] str_type The kind of text (see generate_text).
+* @param[in] str_len The first length (the first Fibonacci index).
+* @param[in] tries Timed runs per data point.
+* @param[in] asize The alphabet size of the random texts.
+**/
+void benchmark_runner(Algorithm alg, StrType str_type, idx_t str_len, int tries, int asize) {
+    idx_t *(*f)(const text*);
+    idx_t *(*f_naive)(const text*);
     char *filename, *header = TIME_BENCHMARK_HEADER;
 
     switch (alg) {
         case SUFFIX_ARRAY:
-            printf("Running benchmark on suffix arrays %d times with random strings[1...%d], |∑| = %d\n", tries, str_len, asize); 
-            f = suffix_array, f_naive = suffix_array_qsort; 
+            printf("Running benchmark on suffix arrays (%s) %d times with %s strings[1...%" PRIdx "], |∑| = %d\n", sa_engine_name(get_sa_engine()), tries, str_type_name(str_type), str_len, asize); 
+            f = suffix_array_engine, f_naive = suffix_array_qsort; 
             filename = SA_BENCH_FILENAME;
             break;
         case LCP:
-            printf("Running benchmark on lcp arrays %d times with random strings[1...%d], |∑| = %d\n", tries, str_len, asize); 
+            printf("Running benchmark on lcp arrays %d times with %s strings[1...%" PRIdx "], |∑| = %d\n", tries, str_type_name(str_type), str_len, asize); 
             return;
         case LPF:
-            printf("Running benchmark on lpf arrays %d times with random strings[1...%d], |∑| = %d\n", tries, str_len, asize); 
+            printf("Running benchmark on lpf arrays (%s, %s) %d times with %s strings[1...%" PRIdx "], |∑| = %d\n", lpf_algorithm_name(get_lpf_algorithm()), sa_engine_name(get_sa_engine()), tries, str_type_name(str_type), str_len, asize); 
             f = lpf_array, f_naive = lpf_array_naive;
+            // The other algorithms are compared with the binode pass
+            if (get_lpf_algorithm() != LPF_BINODE) {
+                f_naive = lpf_array_binode;
+            }
             filename = LPF_BENCH_FILENAME;
             break;
+        case LZ:
+            printf("Running benchmark on the LZ factorization (%s, %s) %d times with %s strings[1...%" PRIdx "], |∑| = %d\n", lpf_algorithm_name(get_lpf_algorithm()), sa_engine_name(get_sa_engine()), tries, str_type_name(str_type), str_len, asize); 
+            f = NULL, f_naive = NULL;
+            filename = LZ_BENCH_FILENAME;
+            break;
+        case STREAM:
+            printf("Running benchmark on the streaming lpf (chunks of %" PRIdx " symbols) %d times with %s strings[1...%" PRIdx "], |∑| = %d\n", stream_chunk, tries, str_type_name(str_type), str_len, asize); 
+            f = NULL, f_naive = NULL;
+            filename = STREAM_BENCH_FILENAME;
+            break;
         default:
             return; 
     }
+    if (!run_naive) {
+        f_naive = NULL;
+    }
+    if (read_counters && perf_open() == 0) {
+        printf("Hardware counters are not available, the counter columns are -1\n");
+    }
+    int timing = get_phase_timing(), merge_timing = get_merge_timing();
+    set_phase_timing(1);
+    set_merge_timing(1);
 
-    file = fopen(filename, "a");
+    data_frame *data = create_data_frame(sweep_points * tries, filename, header);
+    double len = str_len;
 
+    for (int i = 0; i < sweep_points; i++) {
+        idx_t point_len = str_type == FIBONACCI ? str_len + i : (idx_t)(len + 0.5);
+        printf("String length: %" PRIdx "\n", str_type == FIBONACCI ? fibonacci(point_len) : point_len);
+        print_lcp_profile(str_type, point_len, asize);
+        if (alg == LZ) {
+            benchmark_lz(data, str_type, point_len, tries, asize, i * tries);
+        } else if (alg == STREAM) {
+            benchmark_stream(data, str_type, point_len, tries, asize, i * tries);
+        } else {
+            benchmark(f, f_naive, data, str_type, point_len, tries, asize, i * tries);
+        }
+        len *= sweep_growth;
+    }
+
+    FILE *file = fopen(filename, "a");
     if (file == NULL) {
         perror("Error opening file");
+    } else {
+        write_to_csv(data, file);
+        fclose(file);
+    }
+    cleanup_data(data);
+    perf_close();
+    set_phase_timing(timing);
+    set_merge_timing(merge_timing);
+}
+
+// Generates the input of run into *str (allocated on the first call)
+static text benchmark_text(void **str, StrType str_type, idx_t str_len, int *asize, int run) {
+    srand(benchmark_seed + run);
+    return generate_text(str, str_type, str_len, asize);
+}
+
+/**
+* @brief Time f (and f_naive unless it is NULL) on tries texts of one size.
+*
+* The runs are written to data->data[row...row+tries-1], NALG is -1
+* without f_naive. The mean, median, p95 and standard deviation are printed.
+* The time and the peak memory of every phase of f are printed per run. With the counters
+* open every row gets the counters of its f call, and their sum per
+* symbol is printed for the whole call and for each phase.
+**/
+void benchmark(idx_t *(*f)(const text*), idx_t *(*f_naive)(const text*), data_frame *data, StrType str_type, idx_t str_len, int tries, int asize, int row) {
+    double *times = malloc((tries > 0 ? tries : 1) * sizeof(double));
+    double *naive_times = malloc((tries > 0 ? tries : 1) * sizeof(double));
+    void *str = NULL;
+    text t = {NULL, 0, 0, SYM_U8};
+    perf_sample counters, total;
+    phase_stats phases, phase;
+
+    unsigned long long cycles = 0, elements = 0, c, e;
+
+    memset(&total, 0, sizeof(total));
+    memset(&phases, 0, sizeof(phases));
+
+    for (int i = 0; i < warmup_runs && tries > 0; i++) {
+        t = benchmark_text(&str, str_type, str_len, &asize, 0);
+        timeit(f, &t, NULL);
+        if (f_naive != NULL) {
+            timeit(f_naive, &t, NULL);
+        }
     }
 
-    int datapoints = 28;
-    data_frame *data = create_data_frame(datapoints, filename, header);
+    for (int i = 0; i < tries; i++) {
+        t = benchmark_text(&str, str_type, str_len, &asize, i);
 
-    // for (int i = 0; i < datapoints; i++) {
-    //     // str_len = (2 << i) + (2 << (i-1));
-    //     // str_len = (2 << i);
-    //     str_len = i+2;
-    //     printf("String length: %d\n", str_len);
-    //     benchmark(f, f_naive, data, str_type, str_len, tries, asize, i);
-    //     printf("\n");
-    // }
+        reset_merge_stats();
+        reset_phase_stats();
+        times[i] = timeit(f, &t, &counters);
+        merge_stats(&c, &e);
+        cycles += c;
+        elements += e;
+        // The phases of the baseline are not counted
+        add_counters(&total, &counters);
+        get_phase_stats(&phase);
+        add_phase_stats(&phases, &phase);
+        naive_times[i] = f_naive != NULL ? timeit(f_naive, &t, NULL) : 0;
 
-    if (str_type == FIBONACCI) {
-        benchmark(f, f_naive, data, str_type,  str_len, tries, asize, 0);
+        long long *r = data->data[row + i];
+        fill_row(r, t.len, str_type, tries, asize, i);
+        r[4] = SEC_TO_NANO(times[i]);
+        r[5] = f_naive != NULL ? SEC_TO_NANO(naive_times[i]) : -1;
+        set_row_counters(r, &counters);
+    }
+    free(str);
+
+    run_stats st = summarize(times, tries);
+    char name[128];
+    snprintf(name, sizeof(name), "Alg1 (%s, %d-bit indices, %s text, %s)", sa_engine_name(get_sa_engine()), INDEX_BITS, symbol_type_name(t.type), mismatch_kernel_name(get_mismatch_kernel()));
+    print_run_stats(name, &st, tries);
+    if (f_naive != NULL) {
+        st = summarize(naive_times, tries);
+        print_run_stats("Alg2", &st, tries);
     } else {
-        benchmark(f, f_naive, data, str_type, str_len, tries, asize, 0);
+        printf("Alg2: skipped\n");
+    }
+    if (elements > 0) {
+        printf("DC3 merge (%s): %.2f cycles per element\n", merge_kind_name(get_merge_kind()), (double)cycles / elements);
+    }
+    print_phase_times(&phases, tries, t.len);
+    if (perf_available()) {
+        print_run_counters(&total, &phases, tries, t.len);
+    }
+    free(times);
+    free(naive_times);
+}
+
+/**
+* @brief Elapsed (wall-clock) seconds of one call of f, the result is freed.
+*
+* @param[out] counters The hardware counters of the call (-1 if not open), NULL to skip them.
+**/
+double timeit(idx_t *(*f)(const text*), const text *t, perf_sample *counters) {
+    perf_sample start_counters, end_counters;
+    if (counters != NULL) {
+        perf_read(&start_counters);
+    }
+    double start = wall_time();
+    idx_t *sa = f(t);
+    double seconds = wall_time() - start;
+    if (counters != NULL) {
+        perf_read(&end_counters);
+        perf_diff(counters, &end_counters, &start_counters);
     }
+    mem_free(sa, t->len * sizeof(idx_t));
+    return seconds;
+}
 
+/**
+* @brief Benchmark the LZ factorization (LPF, PrevOcc and the factor stream) and its decoder.
+*
+* The stream is written to memory and decoded again, a decoded text
+* which differs from the input is reported. ALG holds the encoding
+* and NALG the decoding time of each run.
+**/
+void benchmark_lz(data_frame *data, StrType str_type, idx_t str_len, int tries, int asize, int row) {
+    double *enc = malloc((tries > 0 ? tries : 1) * sizeof(double));
+    double *dec = malloc((tries > 0 ? tries : 1) * sizeof(double));
+    void *str = NULL;
+    text t = {NULL, 0, 0, SYM_U8};
+    lz_stats stats = {0, 0, 0, 0};
+    perf_sample start_counters, end_counters, counters, total;
+    phase_stats phases, phase;
 
+    memset(&total, 0, sizeof(total));
+    memset(&phases, 0, sizeof(phases));
 
-    // write_to_csv(data, file);
-    cleanup_data(data);
-    fclose(file); 
+    for (int i = -warmup_runs; i < tries; i++) {
+        t = benchmark_text(&str, str_type, str_len, &asize, i < 0 ? 0 : i);
+
+        char *stream = NULL;
+        size_t size = 0;
+        FILE *out = open_memstream(&stream, &size);
+        if (out == NULL) {
+            perror("Error opening memory stream");
+            exit(1);
+        }
+
+        reset_phase_stats();
+        perf_read(&start_counters);
+        double start = wall_time();
+        stats = lz_compress(&t, NULL, out);
+        double enc_time = wall_time() - start;
+        perf_read(&end_counters);
+        perf_diff(&counters, &end_counters, &start_counters);
+        fclose(out);
+
+        start = wall_time();
+        text decoded = lz_decode((uint8_t *)stream, size);
+        double dec_time = wall_time() - start;
+
+        if (decoded.len != t.len || memcmp(decoded.symbols, t.symbols, stats.in_bytes)) {
+            printf("BUG: Decoded text differs from the input\n");
+        }
+        free((void *)decoded.symbols);
+        free(stream);
+
+        // Warmup runs are not recorded
+        if (i >= 0) {
+            enc[i] = enc_time;
+            dec[i] = dec_time;
+            long long *r = data->data[row + i];
+            fill_row(r, t.len, str_type, tries, asize, i);
+            r[4] = SEC_TO_NANO(enc_time);
+            r[5] = SEC_TO_NANO(dec_time);
+            set_row_counters(r, &counters);
+            add_counters(&total, &counters);
+            get_phase_stats(&phase);
+            add_phase_stats(&phases, &phase);
+        }
+    }
+    free(str);
+
+    run_stats st = summarize(enc, tries);
+    printf("Encode (%s, %d-bit indices, %s text, %s): %lld ns per call, median %lld ns, p95 %lld ns, sd %lld ns, ", sa_engine_name(get_sa_engine()), INDEX_BITS, symbol_type_name(t.type), mismatch_kernel_name(get_mismatch_kernel()), SEC_TO_NANO(st.mean), SEC_TO_NANO(st.median), SEC_TO_NANO(st.p95), SEC_TO_NANO(st.stddev));
+    print_lz_stats(&stats, st.mean);
+    st = summarize(dec, tries);
+    printf("Decode: %lld ns per call (%f seconds), median %lld ns, p95 %lld ns, sd %lld ns, %.2f MB/s\n", SEC_TO_NANO(st.mean), st.mean, SEC_TO_NANO(st.median), SEC_TO_NANO(st.p95), SEC_TO_NANO(st.stddev), st.mean > 0 ? stats.in_bytes / st.mean / 1e6 : 0.0);
+    print_phase_times(&phases, tries, t.len);
+    if (perf_available()) {
+        print_run_counters(&total, &phases, tries, t.len);
+    }
+    free(enc);
+    free(dec);
 }
 
-void benchmark(int *(*f)(int*, int), int *(*f_naive)(int*, int), data_frame *data, StrType str_type, int str_len, int tries, int asize, int datapoint) {
-    double ssa = 0, ssaq = 0;
-    long long nssa = 0, nssaq = 0;
-    int *str = NULL;
-    int n = 0;
+/**
+* @brief Benchmark the ingest rate of the streaming LPF.
+*
+* The text is appended in chunks of stream_chunk symbols and the final
+* values are read after every chunk, as a consumer of a live stream
+* would. ALG holds the streaming time and NALG the time of lpf_array on
+* the whole text (-1 without the baseline), whose LPF the stream has to
+* match. The mean rate, the rate of the slowest chunk (the sustained
+* one, the automaton grows as the text does) and the bytes per symbol
+* of the stream are printed.
+**/
+void benchmark_stream(data_frame *data, StrType str_type, idx_t str_len, int tries, int asize, int row) {
+    double *times = malloc((tries > 0 ? tries : 1) * sizeof(double));
+    double *batch_times = malloc((tries > 0 ? tries : 1) * sizeof(double));
+    void *str = NULL;
+    text t = {NULL, 0, 0, SYM_U8};
+    idx_t *lpf = NULL;
+    double slowest = 0;
+    size_t memory = 0;
+    perf_sample start_counters, end_counters, counters, total;
 
-    for (int i = 0; i < tries; i++) {
-        switch (str_type) {
-            case RANDOM:
-                str = random_str(str, str_len, asize);
-                n = str_len;
-                break;
-            case FIBONACCI:
-                str = fib_str(str, str_len);
-                n = fibonacci(str_len);
-                asize = 2;
-                break;
-            default:
-                str = random_str(str, str_len, asize);
-                n = str_len;
-                break;
-        }
-
-        ssa += timeit(f, str, n);
-        ssaq += timeit(f_naive, str, n);
-        // ssaq += 0;
+    memset(&total, 0, sizeof(total));
+
+    for (int i = -warmup_runs; i < tries; i++) {
+        t = benchmark_text(&str, str_type, str_len, &asize, i < 0 ? 0 : i);
+        if (lpf == NULL) {
+            lpf = malloc((t.len > 0 ? t.len : 1) * sizeof(idx_t));
+        }
+
+        lpf_stream *s = lpf_stream_create(t.type);
+        idx_t read = 0;
+        double run_slowest = 0;
+
+        perf_read(&start_counters);
+        double start = wall_time();
+        for (idx_t done = 0; done < t.len;) {
+            idx_t chunk = stream_chunk < t.len - done ? stream_chunk : t.len - done;
+            double chunk_start = wall_time();
+            lpf_stream_append(s, (const char *)t.symbols + (size_t)done * symbol_size(t.type), chunk);
+            read += lpf_stream_read(s, lpf + read, NULL, t.len - read);
+            double seconds = wall_time() - chunk_start;
+            run_slowest = seconds / chunk > run_slowest ? seconds / chunk : run_slowest;
+            done += chunk;
+        }
+        lpf_stream_finish(s);
+        read += lpf_stream_read(s, lpf + read, NULL, t.len - read);
+        double stream_time = wall_time() - start;
+        perf_read(&end_counters);
+        perf_diff(&counters, &end_counters, &start_counters);
+        memory = lpf_stream_memory(s);
+        lpf_stream_free(s);
+
+        double batch_time = -1;
+        if (run_naive) {
+            start = wall_time();
+            idx_t *expected = lpf_array(&t);
+            batch_time = wall_time() - start;
+            if (read != t.len || memcmp(lpf, expected, t.len * sizeof(idx_t))) {
+                printf("BUG: Streamed LPF differs from lpf_array\n");
+            }
+            mem_free(expected, t.len * sizeof(idx_t));
+        }
+
+        // Warmup runs are not recorded
+        if (i >= 0) {
+            times[i] = stream_time;
+            batch_times[i] = batch_time;
+            slowest = run_slowest > slowest ? run_slowest : slowest;
+            long long *r = data->data[row + i];
+            fill_row(r, t.len, str_type, tries, asize, i);
+            r[4] = SEC_TO_NANO(stream_time);
+            r[5] = batch_time >= 0 ? SEC_TO_NANO(batch_time) : -1;
+            set_row_counters(r, &counters);
+            add_counters(&total, &counters);
+        }
     }
     free(str);
+    free(lpf);
 
-    ssa /= tries;
-    ssaq /= tries;
-    nssa = SEC_TO_NANO(ssa);
-    nssaq = SEC_TO_NANO(ssaq);
-
-    data->data[datapoint][0] = n;
-    data->data[datapoint][1] = str_type;
-    data->data[datapoint][2] = tries;
-    data->data[datapoint][3] = asize;
-    data->data[datapoint][4] = nssa;
-    data->data[datapoint][5] = nssaq;
-    
-    printf("Alg1: %lld ns per call (%f seconds), total: %f seconds\n", nssa, ssa, ssa * tries);
-    printf("Alg2: %lld ns per call (%f seconds), total: %f seconds\n", nssaq, ssaq, ssaq * tries);
-}
-
-double timeit(int *(*f)(int*, int), int *str, int str_len) {
-    clock_t start = clock();
-    int *sa = f(str, str_len);
-    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
-    free(sa);
-    return seconds;
+    double bytes = (double)t.len * symbol_size(t.type);
+    run_stats st = summarize(times, tries);
+    printf("Stream (%d-bit indices, %s text): %lld ns per call (%f seconds), median %lld ns, p95 %lld ns, sd %lld ns\n", INDEX_BITS, symbol_type_name(t.type), SEC_TO_NANO(st.mean), st.mean, SEC_TO_NANO(st.median), SEC_TO_NANO(st.p95), SEC_TO_NANO(st.stddev));
+    printf("Ingest: %.2f Msymbols/s (%.2f MB/s), sustained (slowest chunk) %.2f Msymbols/s, %.2f bytes per symbol\n", st.mean > 0 ? t.len / st.mean / 1e6 : 0.0, st.mean > 0 ? bytes / st.mean / 1e6 : 0.0, slowest > 0 ? 1 / slowest / 1e6 : 0.0, t.len > 0 ? (double)memory / t.len : 0.0);
+    if (run_naive) {
+        st = summarize(batch_times, tries);
+        print_run_stats("lpf_array", &st, tries);
+    } else {
+        printf("lpf_array: skipped\n");
+    }
+    if (perf_available()) {
+        print_counters("Counters", &total, tries, t.len);
+    }
+    free(times);
+    free(batch_times);
 }
@@ -1,13 +1,23 @@
 #include "constants.h"
+#include "text.h"
+#include "perf.h"
 
 #ifndef BENCHMARK_H
 #define BENCHMARK_H
 
-void benchmark_runner(Algorithm alg, StrType str_type, int str_len, int tries, int asize);
-void benchmark(int *(*f)(int*, int), int *(*f_naive)(int*, int), data_frame *data, StrType str_type, int str_len, int tries, int asize, int datapoint);
-double timeit(int *(*f)(int*, int), int *str, int str_len);
-int *random_str(int *str, int str_len, int asize);
-void validate_suffix_array(int str_len, int tries, int asize);
-void validate_lpf(int str_len, int tries, int asize);
+void benchmark_runner(Algorithm alg, StrType str_type, idx_t str_len, int tries, int asize);
+void benchmark(idx_t *(*f)(const text*), idx_t *(*f_naive)(const text*), data_frame *data, StrType str_type, idx_t str_len, int tries, int asize, int row);
+void benchmark_lz(data_frame *data, StrType str_type, idx_t str_len, int tries, int asize, int row);
+void benchmark_stream(data_frame *data, StrType str_type, idx_t str_len, int tries, int asize, int row);
+void set_benchmark_warmup(int runs);
+void set_benchmark_sweep(int points, double growth);
+void set_benchmark_naive(int naive);
+void set_benchmark_chunk(idx_t chunk);
+void set_benchmark_seed(unsigned int seed);
+void set_benchmark_counters(int counters);
+double timeit(idx_t *(*f)(const text*), const text *t, perf_sample *counters);
+void validate_suffix_array(StrType str_type, idx_t str_len, int tries, int asize);
+void validate_lpf(StrType str_type, idx_t str_len, int tries, int asize);
+void validate_stream(StrType str_type, idx_t str_len, int tries, int asize);
 
 #endif
\ No newline at end of file
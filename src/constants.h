@@ -1,18 +1,94 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
+#include "liblpf.h"
+
+#include <stdint.h>
+#include <inttypes.h>
+
+// Index type of every array (SA, ISA, LCP, LPF, binode, ...) and of the string lengths,
+// idx_t of liblpf.h. Build with -DLPF_INDEX64 (make lpf64) for inputs beyond 2^31.
+#define INDEX_BITS LPF_INDEX_BITS
+#ifdef LPF_INDEX64
+#define PRIdx PRId64
+#define IDX_MAX INT64_MAX
+#else
+#define PRIdx PRId32
+#define IDX_MAX INT32_MAX
+#endif
+
 #define ALPHABET_SIZE 128
 #define DIV 3
 
-#define MIN_LEN 127
 #define TUPLE_SIZE 3
 #define ADDITIONAL_PADDING 3
 #define DEBUG 0
 
-#define CSV_HEADER_LEN 6
-#define TIME_BENCHMARK_HEADER "IN_LEN,STR_TYPE,TRIES,ALPHABET_SIZE,ALG,NALG"
-#define SA_BENCH_FILENAME "results/sa_bench_results_fib.csv"
+// Inputs of up to SA_SMALL_LEN letters and DC3 reduced problems of up to DC3_CUTOFF
+// names are sorted by multikey quicksort, which hands groups of up to
+// SMALL_SORT_INSERTION suffixes to insertion sort and gives up (to the engine)
+// after SMALL_SORT_WORK letters read per symbol (see suffix_array_small)
+#define SA_SMALL_LEN 512
+#define DC3_CUTOFF 1024
+#define SMALL_SORT_INSERTION 16
+#define SMALL_SORT_WORK 64
+
+// compact_alphabet ranks the symbols with a histogram if the largest one is below either
+// bound (in symbols of the text), with a hash table of the distinct symbols otherwise
+#define ALPHABET_DENSE_MIN (1 << 16)
+#define ALPHABET_DENSE_FACTOR 2
+
+#define MAX_THREADS 64
+#define PARALLEL_MIN_LEN (1 << 15)
+#define PARALLEL_DIGIT_BITS 16
+
+// Widest digit of the packed radix sort and the keys per write-combining buffer (one cache line)
+#define RADIX_MAX_DIGIT_BITS 11
+#define RADIX_WC_ENTRIES 8
+// Narrowest digit, fewer keys than 2^RADIX_MAX_DIGIT_BITS use digits of about log2(keys) bits
+#define RADIX_MIN_DIGIT_BITS 4
+
+// Workspace words per symbol of the lean LPF (without PrevOcc) besides the alphabet buckets
+#define LPF_LEAN_WORDS 3
+
+// Every PLCP_SAMPLE-th set bit of a succinct PLCP is sampled for select
+#define PLCP_SAMPLE 256
+
+// Order-k Markov texts hash longer contexts into this many states, DNA repeats mutate this often
+#define MARKOV_MAX_STATES (1 << 20)
+#define DNA_MUTATION_RATE 0.01
+// Segment lengths of the DNA texts and the longest period of the run-rich texts
+#define DNA_MIN_SEGMENT 20
+#define DNA_MAX_SEGMENT 2000
+#define RUN_MAX_PERIOD 16
+
+// Batch mode: records per block (or fewer if they hold BATCH_SYMBOLS), records a worker takes at once
+#define BATCH_RECORDS (1 << 16)
+#define BATCH_SYMBOLS (1 << 24)
+#define BATCH_GRAB 64
+
+// Streaming LPF: symbols per chunk of the command line and the benchmark, first capacity of its
+// arrays and the edges moved to a grown hash table per inserted edge
+#define STREAM_CHUNK (1 << 16)
+#define STREAM_MIN_CAPACITY 1024
+#define STREAM_REHASH_STEP 2
+
+// Open phases per thread and recursion levels with their own time in phase_stats
+#define PHASE_STACK 256
+#define PHASE_MAX_DEPTH 64
+
+// Hardware counters read by perf.c (cycles, instructions, L1D, LLC and dTLB misses, branch mispredicts)
+#define PERF_EVENTS 6
+#define PERF_CSV_HEADER "CYCLES,INSTRUCTIONS,L1D_MISSES,LLC_MISSES,DTLB_MISSES,BRANCH_MISSES"
+
+// One row per timed run, RUN is its index and SEED the seed of its random text
+// and the counters of ALG follow (-1 if they were not read)
+#define CSV_HEADER_LEN (11 + PERF_EVENTS)
+#define TIME_BENCHMARK_HEADER "IN_LEN,STR_TYPE,TRIES,ALPHABET_SIZE,ALG,NALG,ENGINE,INDEX_BITS,LPF_ALG,RUN,SEED," PERF_CSV_HEADER
+#define SA_BENCH_FILENAME "results/sa_bench_results.csv"
 #define LPF_BENCH_FILENAME "results/lpf_bench_results.csv"
+#define LZ_BENCH_FILENAME "results/lz_bench_results.csv"
+#define STREAM_BENCH_FILENAME "results/stream_bench_results.csv"
 
 #if DEBUG
     #define LOG_MESSAGE(...) printf(__VA_ARGS__)
@@ -28,22 +104,79 @@ enum Algorithm {
     SUFFIX_ARRAY,
     LCP,
     LPF,
+    LZ,
+    STREAM,
 };
 typedef enum Algorithm Algorithm;
 
+// Framing of the batch records: one per line or a 32-bit little-endian length before each
+enum RecordFormat {
+    RECORDS_LINES,
+    RECORDS_PREFIXED,
+};
+typedef enum RecordFormat RecordFormat;
+
+// SAEngine and LPFAlgorithm are part of the library interface (liblpf.h)
+
+// Pipeline phases timed by phase.c, a phase may contain others (SA holds the DC3 steps)
+enum Phase {
+    PHASE_SA,
+    PHASE_TUPLES,
+    PHASE_RADIX_PASS,
+    PHASE_NAMING,
+    PHASE_RECURSION,
+    PHASE_T0_SORT,
+    PHASE_MERGE,
+    PHASE_ISA,
+    PHASE_LCP,
+    PHASE_BINODE,
+    PHASE_LPF,
+    PHASE_ENCODE,
+    PHASE_COUNT,
+};
+typedef enum Phase Phase;
+
+enum RadixKind {
+    RADIX_PACKED,
+    RADIX_TUPLES,
+};
+typedef enum RadixKind RadixKind;
+
+enum MergeKind {
+    MERGE_PACKED,
+    MERGE_TUPLES,
+};
+typedef enum MergeKind MergeKind;
+
+enum MismatchKernel {
+    MISMATCH_AUTO,
+    MISMATCH_SCALAR,
+    MISMATCH_SSE2,
+    MISMATCH_AVX2,
+};
+typedef enum MismatchKernel MismatchKernel;
+
+// Benchmark and validation inputs generated by corpus.c, the value is the STR_TYPE column
 enum StrType {
     RANDOM,
     FIBONACCI,
+    THUE_MORSE,
+    PERIOD_DOUBLING,
+    RUN_RICH,
+    MARKOV,
+    DNA,
+    CORPUS_FILE,
 };
 typedef enum StrType StrType;
 
 struct tuple_info {
-    int *positions;
-    int *tuple_sorting;
-    int *tuple_type;
-    int (*values)[TUPLE_SIZE];
-    int total_blocks;
-    int max_name;
+    idx_t *positions;
+    idx_t *tuple_sorting;
+    idx_t *tuple_type;
+    idx_t (*values)[TUPLE_SIZE];
+    idx_t total_blocks;
+    idx_t max_name;
+    idx_t key_range; // Every value is in [0, key_range)
 };
 typedef struct tuple_info tuple_info;
 
@@ -0,0 +1,358 @@
+#include "corpus.h"
+#include "input.h"
+#include "text.h"
+#include "util.h"
+#include "constants.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+static int markov_order = 3;
+static double markov_entropy = 1.0;
+static double dna_repeats = 0.5;
+static const char *corpus_path = NULL;
+static SymbolType corpus_type = SYM_U8;
+static input_file corpus_in;
+static text corpus;
+static int corpus_open = 0;
+
+static const char dna_bases[4] = {'a', 'c', 'g', 't'};
+
+/**
+* @brief Order of the Markov texts, every letter depends on the order letters before it.
+**/
+void set_markov_order(int order) {
+    markov_order = order < 0 ? 0 : order;
+}
+
+/**
+* @brief Entropy of the Markov texts in bits per letter given its context,
+* from 0 (periodic) to log2(asize) (uniform random).
+**/
+void set_markov_entropy(double bits) {
+    markov_entropy = bits < 0 ? 0 : bits;
+}
+
+/**
+* @brief Fraction of the DNA texts copied from earlier in the text.
+**/
+void set_dna_repeats(double fraction) {
+    dna_repeats = fraction < 0 ? 0 : (fraction > 1 ? 1 : fraction);
+}
+
+/**
+* @brief The file the CORPUS_FILE texts are sampled from.
+*
+* It is mapped on first use (see map_input_file) and stays mapped.
+**/
+void set_corpus_file(const char *path, SymbolType type) {
+    if (corpus_open) {
+        close_input(&corpus_in);
+        corpus_open = 0;
+    }
+    corpus_path = path;
+    corpus_type = type;
+}
+
+static void put_symbol(void *str, SymbolType type, idx_t i, idx_t sym) {
+    switch (type) {
+        case SYM_U8:
+            ((uint8_t *)str)[i] = (uint8_t)sym;
+            break;
+        case SYM_U16:
+            ((uint16_t *)str)[i] = (uint16_t)sym;
+            break;
+        default:
+            ((uint32_t *)str)[i] = (uint32_t)sym;
+            break;
+    }
+}
+
+// Uniform in [0, 1)
+static double random_unit() {
+    return rand() / (RAND_MAX + 1.0);
+}
+
+// Uniform in [0, n), rand() alone has 31 bits
+static idx_t random_index(idx_t n) {
+    unsigned long long r = ((unsigned long long)rand() << 31) ^ (unsigned long long)rand();
+    return (idx_t)(r % (unsigned long long)n);
+}
+
+static void *text_buffer(void *str, idx_t len, SymbolType type) {
+    if (str == NULL) {
+        str = malloc((len > 0 ? len : 1) * symbol_size(type));
+        if (str == NULL) {
+            perror("Error allocating text");
+            exit(1);
+        }
+    }
+    return str;
+}
+
+// t[i] is the parity of the ones of i (Thue-Morse) or of the trailing zeros of i+1 (period-doubling)
+static text binary_morphic(void *str, StrType type, idx_t len) {
+    uint8_t *s = text_buffer(str, len, SYM_U8);
+    for (idx_t i = 0; i < len; i++) {
+        int bit = type == THUE_MORSE ? __builtin_parityll((unsigned long long)i) : __builtin_ctzll((unsigned long long)i + 1) & 1;
+        s[i] = (uint8_t)('a' + bit);
+    }
+    return text_init(s, len, SYM_U8, 'b' + 1);
+}
+
+/**
+* @brief A text made of runs: a random block of period at most
+* RUN_MAX_PERIOD (short periods more likely) repeated 2 to 5 times
+* plus a random prefix of it, then the next block.
+**/
+static text run_rich(void *str, idx_t len, int asize) {
+    SymbolType type = symbol_type_for(97 + asize);
+    str = text_buffer(str, len, type);
+    idx_t block[RUN_MAX_PERIOD];
+
+    for (idx_t i = 0; i < len;) {
+        idx_t period = 1 + rand() % (1 + rand() % RUN_MAX_PERIOD);
+        idx_t run = period * (2 + rand() % 4) + rand() % period;
+        for (idx_t j = 0; j < period; j++) {
+            block[j] = 97 + rand() % asize;
+        }
+        for (idx_t j = 0; j < run && i < len; j++, i++) {
+            put_symbol(str, type, i, block[j % period]);
+        }
+    }
+    return text_init(str, len, type, 97 + asize);
+}
+
+// Entropy in bits of a letter which is the preferred one with probability p, any other one otherwise
+static double bias_entropy(double p, int asize) {
+    double h = p > 0 ? -p * log2(p) : 0;
+    if (p < 1) {
+        h -= (1 - p) * log2((1 - p) / (asize - 1));
+    }
+    return h;
+}
+
+/**
+* @brief Order-k Markov text with the entropy set_markov_entropy.
+*
+* Every context (the k letters before, hashed into MARKOV_MAX_STATES
+* states if there are more) has a random preferred next letter. It is
+* taken with the probability p whose entropy is the requested one, one
+* of the other letters uniformly otherwise. Order 0 is a skewed
+* memoryless source.
+**/
+static text markov(void *str, idx_t len, int asize) {
+    SymbolType type = symbol_type_for(97 + asize);
+    str = text_buffer(str, len, type);
+
+    long long states = 1;
+    for (int i = 0; i < markov_order && states < MARKOV_MAX_STATES; i++) {
+        states *= asize;
+    }
+    states = states < MARKOV_MAX_STATES ? states : MARKOV_MAX_STATES;
+
+    idx_t *preferred = malloc(states * sizeof(idx_t));
+    if (preferred == NULL) {
+        perror("Error allocating Markov states");
+        exit(1);
+    }
+    for (long long i = 0; i < states; i++) {
+        preferred[i] = rand() % asize;
+    }
+
+    // The entropy falls from log2(asize) at p = 1/asize to 0 at p = 1
+    double lo = 1.0 / asize, hi = 1;
+    for (int i = 0; i < 64; i++) {
+        double mid = (lo + hi) / 2;
+        if (bias_entropy(mid, asize) > markov_entropy) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    long long ctx = 0;
+    for (idx_t i = 0; i < len; i++) {
+        idx_t sym = preferred[ctx];
+        if (asize > 1 && random_unit() >= lo) {
+            sym = rand() % (asize - 1);
+            sym += sym >= preferred[ctx];
+        }
+        put_symbol(str, type, i, 97 + sym);
+        ctx = (ctx * asize + sym) % states;
+    }
+    free(preferred);
+    return text_init(str, len, type, 97 + asize);
+}
+
+static int base_code(uint8_t base) {
+    return base == 'a' ? 0 : (base == 'c' ? 1 : (base == 'g' ? 2 : 3));
+}
+
+/**
+* @brief DNA-like text over acgt with planted repeats.
+*
+* The text is built from segments of DNA_MIN_SEGMENT...DNA_MAX_SEGMENT
+* bases. A segment is a copy of an earlier one (a reverse complement
+* one time in four) with DNA_MUTATION_RATE substitutions with the
+* probability set_dna_repeats, uniformly random otherwise.
+**/
+static text dna(void *str, idx_t len) {
+    uint8_t *s = text_buffer(str, len, SYM_U8);
+
+    for (idx_t i = 0; i < len;) {
+        idx_t seg = DNA_MIN_SEGMENT + rand() % (DNA_MAX_SEGMENT - DNA_MIN_SEGMENT + 1);
+        seg = seg < len - i ? seg : len - i;
+
+        if (i >= seg && random_unit() < dna_repeats) {
+            idx_t src = random_index(i - seg + 1);
+            int reverse = rand() % 4 == 0;
+            for (idx_t j = 0; j < seg; j++) {
+                int b = reverse ? 3 - base_code(s[src + seg-1 - j]) : base_code(s[src + j]);
+                if (random_unit() < DNA_MUTATION_RATE) {
+                    b = rand() % 4;
+                }
+                s[i + j] = (uint8_t)dna_bases[b];
+            }
+        } else {
+            for (idx_t j = 0; j < seg; j++) {
+                s[i + j] = (uint8_t)dna_bases[rand() % 4];
+            }
+        }
+        i += seg;
+    }
+    return text_init(s, len, SYM_U8, 't' + 1);
+}
+
+// A random window of len symbols of the corpus file, the text points into the mapping
+static text corpus_window(idx_t len) {
+    if (corpus_path == NULL) {
+        fprintf(stderr, "No corpus file, set one with --corpus\n");
+        exit(1);
+    }
+    if (!corpus_open) {
+        corpus = map_input_file(&corpus_in, corpus_path, corpus_type);
+        corpus_open = 1;
+    }
+    if (corpus.len < len) {
+        fprintf(stderr, "Corpus %s has %" PRIdx " symbols, %" PRIdx " requested\n", corpus_path, corpus.len, len);
+        exit(1);
+    }
+
+    idx_t start = random_index(corpus.len - len + 1);
+    const char *symbols = (const char *)corpus.symbols + (size_t)start * symbol_size(corpus.type);
+    return text_init(symbols, len, corpus.type, corpus.alphabet);
+}
+
+/**
+* @brief Generate a benchmark or validation text.
+*
+* The random types draw from rand(), seed it with srand for a
+* reproducible text. For FIBONACCI len is the index of the word.
+*
+* @param[in,out] str The buffer of the text, NULL to allocate it (free it
+*   with free). A buffer of an earlier call with the same type and
+*   length is reused. The corpus windows need none and leave it NULL.
+* @param[in] type The kind of text.
+* @param[in] len The length of the text.
+* @param[in,out] asize The alphabet size of the random, run-rich and
+*   Markov texts, set to the alphabet size of the others.
+*
+* @return Returns the text.
+**/
+text generate_text(void **str, StrType type, idx_t len, int *asize) {
+    text t;
+
+    switch (type) {
+        case FIBONACCI:
+            *str = fib_str(*str, len);
+            t = text_init(*str, fibonacci(len), SYM_U8, 'b' + 1);
+            *asize = 2;
+            return t;
+        case THUE_MORSE:
+        case PERIOD_DOUBLING:
+            t = binary_morphic(*str, type, len);
+            *asize = 2;
+            break;
+        case RUN_RICH:
+            t = run_rich(*str, len, *asize);
+            break;
+        case MARKOV:
+            t = markov(*str, len, *asize);
+            break;
+        case DNA:
+            t = dna(*str, len);
+            *asize = 4;
+            break;
+        case CORPUS_FILE:
+            t = corpus_window(len);
+            *asize = t.alphabet;
+            return t;
+        case RANDOM:
+        default:
+            t = random_text(*str, len, *asize);
+            break;
+    }
+    *str = (void *)t.symbols;
+    return t;
+}
+
+const char *str_type_name(StrType type) {
+    switch (type) {
+        case FIBONACCI:
+            return "Fibonacci";
+        case THUE_MORSE:
+            return "Thue-Morse";
+        case PERIOD_DOUBLING:
+            return "period-doubling";
+        case RUN_RICH:
+            return "run-rich";
+        case MARKOV:
+            return "Markov";
+        case DNA:
+            return "DNA";
+        case CORPUS_FILE:
+            return "corpus";
+        case RANDOM:
+        default:
+            return "random";
+    }
+}
+
+/**
+* @brief Parse the text letter of -b and -v: r(andom), f(ibonacci), t(hue-morse),
+* p(eriod-doubling), u (run-rich), m(arkov), d(na) or c(orpus).
+*
+* @return Returns 1 if the letter was recognized, 0 otherwise.
+**/
+int parse_str_type(char name, StrType *type) {
+    switch (name) {
+        case 'r':
+            *type = RANDOM;
+            return 1;
+        case 'f':
+            *type = FIBONACCI;
+            return 1;
+        case 't':
+            *type = THUE_MORSE;
+            return 1;
+        case 'p':
+            *type = PERIOD_DOUBLING;
+            return 1;
+        case 'u':
+            *type = RUN_RICH;
+            return 1;
+        case 'm':
+            *type = MARKOV;
+            return 1;
+        case 'd':
+            *type = DNA;
+            return 1;
+        case 'c':
+            *type = CORPUS_FILE;
+            return 1;
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,15 @@
+#include "constants.h"
+#include "text.h"
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+text generate_text(void **str, StrType type, idx_t len, int *asize);
+void set_markov_order(int order);
+void set_markov_entropy(double bits);
+void set_dna_repeats(double fraction);
+void set_corpus_file(const char *path, SymbolType type);
+const char *str_type_name(StrType type);
+int parse_str_type(char name, StrType *type);
+
+#endif
@@ -0,0 +1,171 @@
+#include "input.h"
+#include "text.h"
+#include "liblpf.h"
+#include "workspace.h"
+#include "constants.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+* @brief Read one line from stdin as a byte text.
+*
+* The text points into the line buffer, the delimiter is not part of it.
+*
+* @param[out] in Owns the buffer, release it with close_input.
+*
+* @return Returns the text.
+**/
+text read_input_line(input_file *in) {
+    char *input = NULL;
+    size_t input_length = 0;
+    ssize_t nread;
+
+    printf("Enter a string: ");
+    if ((nread = getdelim(&input, &input_length, '\n', stdin)) == -1) {
+        exit(1);
+    }
+    if (nread > 0 && input[nread-1] == '\n') {
+        nread--;
+    }
+    printf("Retrieved line of length %zd\n", nread);
+    LOG_FUNC(fwrite, input, nread, 1, stdout);
+    printf("\n");
+
+    in->data = input;
+    in->size = nread;
+    in->mapped = 0;
+    in->letters = NULL;
+    return text_init(input, (idx_t)nread, SYM_U8, 1 << 8);
+}
+
+// Reads a pipe, FIFO or device to its end into a malloc buffer, returns its size
+static size_t read_stream(int fd, void **data) {
+    size_t size = 0, cap = 1 << 16;
+    char *buf = malloc(cap);
+
+    for (;;) {
+        if (buf == NULL) {
+            perror("Error allocating the input");
+            exit(1);
+        }
+        ssize_t got = read(fd, buf + size, cap - size);
+        if (got < 0) {
+            perror("Error reading input file");
+            exit(1);
+        }
+        if (got == 0) {
+            break;
+        }
+        size += got;
+        if (size == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+    }
+    *data = buf;
+    return size;
+}
+
+/**
+* @brief Map a file read-only and describe it as a text.
+*
+* A byte file is used in place, there is no copy. Every byte value
+* (including '\0' and '\n') is a symbol. With a wider symbol type the file
+* holds native-endian 16- or 32-bit symbols and its size must be a multiple
+* of the width. Those are compacted to the ranks of the distinct symbols,
+* so any 32-bit values fit the index type and the buckets of the engines,
+* in->map holds the original symbols. A pipe, FIFO or device (which has
+* no size to map) is read to its end into memory instead.
+*
+* @param[out] in Owns the mapping, release it with close_input.
+* @param[in] path The file.
+* @param[in] type The symbol type of the file.
+*
+* @return Returns the text.
+**/
+text map_input_file(input_file *in, const char *path, SymbolType type) {
+    struct stat st;
+    size_t width = symbol_size(type);
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        perror("Error opening input file");
+        exit(1);
+    }
+
+    in->data = NULL;
+    in->letters = NULL;
+    if (S_ISREG(st.st_mode)) {
+        in->size = st.st_size;
+        in->mapped = st.st_size > 0;
+    } else {
+        in->size = read_stream(fd, &in->data);
+        in->mapped = 0;
+    }
+
+    if (in->size % width != 0) {
+        fprintf(stderr, "File size %zu is not a multiple of the symbol width (%zu bytes)\n", in->size, width);
+        exit(1);
+    }
+    if ((unsigned long long)in->size / width >= (unsigned long long)IDX_MAX) {
+        fprintf(stderr, "File has too many symbols for %d-bit indices (build lpf64)\n", INDEX_BITS);
+        exit(1);
+    }
+    if (in->mapped) {
+        in->data = mmap(NULL, in->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (in->data == MAP_FAILED) {
+            perror("Error mapping input file");
+            exit(1);
+        }
+    }
+    close(fd);
+
+    if (type == SYM_U8) {
+        return text_init(in->data, (idx_t)in->size, type, 1 << 8);
+    }
+    text t = compact_alphabet(in->data, (idx_t)(in->size / width), type, NULL, &in->map);
+    in->letters = (void *)t.symbols;
+    in->letters_size = (size_t)t.len * symbol_size(t.type);
+    return t;
+}
+
+void close_input(input_file *in) {
+    if (in->letters != NULL) {
+        mem_free(in->letters, in->letters_size);
+        cleanup_alphabet_map(&in->map);
+        in->letters = NULL;
+    }
+    if (in->mapped) {
+        munmap(in->data, in->size);
+    } else {
+        free(in->data);
+    }
+    in->data = NULL;
+}
+
+/**
+* @brief Parse the symbol width of an input file ("8", "16" or "32").
+*
+* @return Returns 1 if the width was recognized, 0 otherwise.
+**/
+int parse_symbol_width(const char *name, SymbolType *type) {
+    if (!strcmp(name, "8")) {
+        *type = SYM_U8;
+        return 1;
+    }
+    if (!strcmp(name, "16")) {
+        *type = SYM_U16;
+        return 1;
+    }
+    if (!strcmp(name, "32")) {
+        *type = SYM_U32;
+        return 1;
+    }
+    return 0;
+}
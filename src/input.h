@@ -0,0 +1,26 @@
+#include "constants.h"
+#include "text.h"
+#include "liblpf.h"
+
+#include <stddef.h>
+
+#ifndef INPUT_H
+#define INPUT_H
+
+// A file of wide symbols is read through its compacted letters (see compact_alphabet)
+struct input_file {
+    void *data;
+    size_t size;
+    int mapped;
+    void *letters;
+    size_t letters_size;
+    alphabet_map map;
+};
+typedef struct input_file input_file;
+
+text read_input_line(input_file *in);
+text map_input_file(input_file *in, const char *path, SymbolType type);
+void close_input(input_file *in);
+int parse_symbol_width(const char *name, SymbolType *type);
+
+#endif
@@ -1,6 +1,42 @@
+#include "lcp.h"
+#include "text.h"
+#include "parallel.h"
+#include "mismatch.h"
 #include "suffix_array.h"
+#include "workspace.h"
 
 #include <stdlib.h>
+#include <stdio.h>
+
+#define SYMBOL_KERNELS "lcp_kernels.inc"
+#include "symbol_template.h"
+
+struct plcp_job {
+    const text *t;
+    idx_t *sa;
+    idx_t *plcp;
+};
+typedef struct plcp_job plcp_job;
+
+static void phi_chunk(void *arg, int id, int chunks) {
+    plcp_job *job = arg;
+    idx_t from = chunk_begin(job->t->len, id, chunks);
+    idx_t to = chunk_begin(job->t->len, id+1, chunks);
+
+    for (idx_t i = from > 0 ? from : 1; i < to; i++) {
+        job->plcp[job->sa[i]] = job->sa[i-1];
+    }
+}
+
+// Every chunk starts with k = 0, only the first LCP of a chunk loses the carried value
+static void plcp_chunk(void *arg, int id, int chunks) {
+    plcp_job *job = arg;
+    const text *t = job->t;
+    idx_t from = chunk_begin(t->len, id, chunks);
+    idx_t to = chunk_begin(t->len, id+1, chunks);
+
+    TEXT_DISPATCH(t, plcp_phi, t->len, job->plcp, from, to);
+}
 
 /**
 * @brief Calculates the longest common prefix table.
@@ -11,40 +47,29 @@
 * This algorithm uses the relation:
 * LCP[SA^(-1)[i]] - 1 <= LCP[SA^(-1)[i+1]]
 * 
-* which gives O(n) time complexity.
+* which gives O(n) time complexity. The letters are compared in the
+* symbol width of the text.
 *
+* @param[in] t The text.
 * @param[in] sa Suffix array.
-* @param[in] len Length of sa.
+* @param[in] sar Inverse suffix array.
 *
 * @return Returns the LCP array (First index is not relevant).
 **/
-int *lcp_array(int *str, int *sa, int *sar, int len) {
-    int *lcp = malloc(len * sizeof(int));
-
-    lcp[0] = 0;
-    int k = 0;
-
-    for (int i = 0; i < len; i++) {
-        int pos = sar[i];
-        if (pos > 0) {
-            int ppos = sa[pos - 1];
-            int m = ppos > i ? len - ppos - k : len - i - k;        
-
-            int inc = 0;
-            for (int j = 0; j < m; j++) {
-                if (str[ppos + j + k] != str[i + j + k]) {
-                    break;
-                }
-                inc++;
-            }
-            k += inc;
-            lcp[pos] = k;
-
-            if (k > 0) {
-                k--;
-            }
-        }
-    }
+idx_t *lcp_array(const text *t, idx_t *sa, idx_t *sar) {
+    idx_t *lcp = mem_alloc(t->len * sizeof(idx_t));
+    return lcp_array_into(t, sa, sar, lcp);
+}
+
+/**
+* @brief Calculates the longest common prefix table into a given array.
+*
+* @param[out] lcp Output array of size t->len.
+*
+* @return Returns lcp.
+**/
+idx_t *lcp_array_into(const text *t, idx_t *sa, idx_t *sar, idx_t *lcp) {
+    TEXT_DISPATCH(t, lcp_kasai, sa, sar, t->len, lcp);
     return lcp;
 }
 
@@ -59,10 +84,160 @@ int *lcp_array(int *str, int *sa, int *sar, int len) {
 *
 * @return Returns the reversed array
 **/
-int *reverse_array(int *arr, int len) {
-    int *arr_rev = malloc(len * sizeof(int));
-    for (int i = 0; i < len; i++) {
+idx_t *reverse_array(idx_t *arr, idx_t len) {
+    idx_t *arr_rev = mem_alloc(len * sizeof(idx_t));
+    return reverse_array_into(arr, len, arr_rev);
+}
+
+idx_t *reverse_array_into(idx_t *arr, idx_t len, idx_t *arr_rev) {
+    for (idx_t i = 0; i < len; i++) {
         arr_rev[arr[i]] = i;
     } 
     return arr_rev;
-}
\ No newline at end of file
+}
+
+/**
+* @brief Calculates the permuted LCP table with the PHI algorithm.
+*
+* PLCP[i] is the LCP of suffix i with the suffix before it in SA, so
+* LCP[i] = PLCP[SA[i]]. This is the algorithm of Kärkkäinen, Manzini
+* and Puglisi (https://doi.org/10.1007/978-3-642-02441-2_17).
+* PHI[SA[i]] = SA[i-1] replaces the inverse suffix array and is turned
+* into PLCP in place, so only one array of n words is needed on top of SA.
+* The text is scanned left to right which keeps the letter comparisons
+* local, unlike Kasai which writes LCP in SA order. Both passes are
+* split into chunks of the text for the threads.
+*
+* @param[in] t The text.
+* @param[in] sa Suffix array.
+*
+* @return Returns the PLCP array.
+**/
+idx_t *plcp_array(const text *t, idx_t *sa) {
+    idx_t *plcp = mem_alloc(t->len * sizeof(idx_t));
+    return plcp_array_into(t, sa, plcp);
+}
+
+/**
+* @brief Calculates the PLCP table into a given array.
+*
+* @param[out] plcp Output array of size t->len.
+*
+* @return Returns plcp.
+**/
+idx_t *plcp_array_into(const text *t, idx_t *sa, idx_t *plcp) {
+    idx_t len = t->len;
+    if (len == 0) {
+        return plcp;
+    }
+    plcp_job job = {t, sa, plcp};
+    int chunks = parallel_chunks(len);
+
+    plcp[sa[0]] = -1;
+    parallel_run(phi_chunk, &job, chunks);
+    parallel_run(plcp_chunk, &job, chunks);
+    return plcp;
+}
+
+/**
+* @brief Rearranges PLCP into SA order, LCP[i] = PLCP[SA[i]].
+*
+* @param[in] plcp The PLCP array.
+* @param[in] sa Suffix array.
+* @param[in] len Length of the arrays.
+* @param[out] lcp Output array of size len (must not be plcp).
+*
+* @return Returns lcp (First index is 0).
+**/
+idx_t *lcp_from_plcp_into(idx_t *plcp, idx_t *sa, idx_t len, idx_t *lcp) {
+    for (idx_t i = 0; i < len; i++) {
+        lcp[i] = plcp[sa[i]];
+    }
+    return lcp;
+}
+
+// Words of the 2n-bit vector (with one spare) and the number of select samples
+static size_t succinct_words(idx_t len) {
+    return (2 * (size_t)len + 63) / 64 + 1;
+}
+
+static size_t succinct_samples(idx_t len) {
+    return (size_t)len / PLCP_SAMPLE + 1;
+}
+
+/**
+* @brief Calculates the PLCP table in a succinct form of 2n bits.
+*
+* The PLCP array is built with PHI in a temporary array and then
+* encoded as a bit vector, every PLCP_SAMPLE-th set bit is sampled to
+* answer select. Kept next to SA it gives LCP values on demand in
+* 2 bits per letter instead of a word.
+*
+* @param[in] t The text.
+* @param[in] sa Suffix array.
+*
+* @return Returns the succinct PLCP (free it with cleanup_succinct_plcp).
+**/
+succinct_plcp *succinct_plcp_create(const text *t, idx_t *sa) {
+    idx_t len = t->len;
+    succinct_plcp *s = malloc(sizeof(succinct_plcp));
+
+    s->len = len;
+    s->bits = mem_calloc(succinct_words(len), sizeof(uint64_t));
+    s->samples = mem_alloc(succinct_samples(len) * sizeof(size_t));
+
+    idx_t *plcp = plcp_array(t, sa);
+    for (idx_t i = 0; i < len; i++) {
+        size_t pos = (size_t)plcp[i] + 2 * (size_t)i;
+        s->bits[pos / 64] |= 1ULL << (pos % 64);
+        if (i % PLCP_SAMPLE == 0) {
+            s->samples[i / PLCP_SAMPLE] = pos;
+        }
+    }
+    mem_free(plcp, len * sizeof(idx_t));
+    return s;
+}
+
+void cleanup_succinct_plcp(succinct_plcp *s) {
+    if (s == NULL) {
+        return;
+    }
+    mem_free(s->bits, succinct_words(s->len) * sizeof(uint64_t));
+    mem_free(s->samples, succinct_samples(s->len) * sizeof(size_t));
+    free(s);
+}
+
+/**
+* @brief PLCP[i] of a succinct PLCP.
+*
+* The sampled position of set bit i - i % PLCP_SAMPLE is the start,
+* the remaining set bits are skipped a word at a time with popcount.
+**/
+idx_t succinct_plcp_get(const succinct_plcp *s, idx_t i) {
+    size_t pos = s->samples[i / PLCP_SAMPLE];
+    int skip = i % PLCP_SAMPLE;
+    size_t w = pos / 64;
+    uint64_t word = s->bits[w] & (~0ULL << (pos % 64));
+
+    for (int c = __builtin_popcountll(word); skip >= c; c = __builtin_popcountll(word)) {
+        skip -= c;
+        word = s->bits[++w];
+    }
+    for (; skip > 0; skip--) {
+        word &= word - 1;
+    }
+    return (idx_t)(w * 64 + __builtin_ctzll(word) - 2 * (size_t)i);
+}
+
+/**
+* @brief LCP[i] (in SA order) on demand from a succinct PLCP.
+*
+* @return Returns PLCP[SA[i]] (0 for i = 0).
+**/
+idx_t succinct_lcp_get(const succinct_plcp *s, const idx_t *sa, idx_t i) {
+    return i > 0 ? succinct_plcp_get(s, sa[i]) : 0;
+}
+
+size_t succinct_plcp_bytes(const succinct_plcp *s) {
+    return ((2 * (size_t)s->len + 63) / 64 + 1) * sizeof(uint64_t) + ((size_t)s->len / PLCP_SAMPLE + 1) * sizeof(size_t);
+}
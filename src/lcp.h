@@ -1,7 +1,34 @@
+#include "constants.h"
+#include "text.h"
+
+#include <stdint.h>
+
 #ifndef LCP_H
 #define LCP_H
 
-int *lcp_array(int *str, int *sa, int *sar, int len);
-int *reverse_array(int *arr, int len);
+idx_t *lcp_array(const text *t, idx_t *sa, idx_t *sar);
+idx_t *lcp_array_into(const text *t, idx_t *sa, idx_t *sar, idx_t *lcp);
+idx_t *plcp_array(const text *t, idx_t *sa);
+idx_t *plcp_array_into(const text *t, idx_t *sa, idx_t *plcp);
+idx_t *lcp_from_plcp_into(idx_t *plcp, idx_t *sa, idx_t len, idx_t *lcp);
+idx_t *reverse_array(idx_t *arr, idx_t len);
+idx_t *reverse_array_into(idx_t *arr, idx_t len, idx_t *arr_rev);
+
+/*
+* PLCP as a bit vector of 2n bits: PLCP[i] + i never decreases, so bit
+* PLCP[i] + 2i is set for every i and PLCP[i] = select(i) - 2i.
+*/
+struct succinct_plcp {
+    uint64_t *bits;
+    size_t *samples;
+    idx_t len;
+};
+typedef struct succinct_plcp succinct_plcp;
+
+succinct_plcp *succinct_plcp_create(const text *t, idx_t *sa);
+void cleanup_succinct_plcp(succinct_plcp *s);
+idx_t succinct_plcp_get(const succinct_plcp *s, idx_t i);
+idx_t succinct_lcp_get(const succinct_plcp *s, const idx_t *sa, idx_t i);
+size_t succinct_plcp_bytes(const succinct_plcp *s);
 
 #endif
\ No newline at end of file
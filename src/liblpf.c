@@ -0,0 +1,152 @@
+#include "liblpf.h"
+#include "lpf.h"
+#include "lcp.h"
+#include "text.h"
+#include "parallel.h"
+#include "workspace.h"
+#include "constants.h"
+#include "suffix_array.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+struct lpf_context {
+    workspace *ws;
+    SAEngine engine;
+    LPFAlgorithm algorithm;
+    int threads;
+};
+
+// The settings of the calling thread while a context call runs
+struct lpf_settings {
+    SAEngine engine;
+    LPFAlgorithm algorithm;
+    int threads;
+};
+typedef struct lpf_settings lpf_settings;
+
+static lpf_settings apply_context(const lpf_context *ctx) {
+    lpf_settings prev = {get_sa_engine(), get_lpf_algorithm(), get_thread_count()};
+    set_sa_engine(ctx->engine);
+    set_lpf_algorithm(ctx->algorithm);
+    set_thread_count(ctx->threads);
+    return prev;
+}
+
+static void restore_settings(const lpf_settings *prev) {
+    set_sa_engine(prev->engine);
+    set_lpf_algorithm(prev->algorithm);
+    set_thread_count(prev->threads);
+}
+
+int lpf_index_bits(void) {
+    return INDEX_BITS;
+}
+
+// Output buffer of len words, the caller's or a new one
+static idx_t *output_buffer(idx_t *out, idx_t len) {
+    return out != NULL ? out : mem_alloc(len * sizeof(idx_t));
+}
+
+/**
+* @brief Create a context for the suffix array, PLCP and LPF calls.
+*
+* The workspace is empty until the first call or lpf_context_reserve.
+*
+* @param[in] engine The suffix array engine (DC3 or SAIS).
+* @param[in] algorithm The LPF algorithm.
+* @param[in] threads The threads of every call (1 to run on the calling thread only).
+*
+* @return Returns the context, free it with lpf_context_free.
+**/
+lpf_context *lpf_context_create(SAEngine engine, LPFAlgorithm algorithm, int threads) {
+    lpf_context *ctx = malloc(sizeof(lpf_context));
+    if (ctx == NULL) {
+        perror("Error allocating context");
+        exit(1);
+    }
+    ctx->ws = create_workspace(0);
+    ctx->engine = engine;
+    ctx->algorithm = algorithm;
+    ctx->threads = threads;
+    return ctx;
+}
+
+void lpf_context_free(lpf_context *ctx) {
+    if (ctx == NULL) {
+        return;
+    }
+    cleanup_workspace(ctx->ws);
+    free(ctx);
+}
+
+/**
+* @brief Grow the workspace for every call on texts up to the length and alphabet of t.
+*
+* Without it the workspace grows on the first call which needs more.
+**/
+void lpf_context_reserve(lpf_context *ctx, const text *t) {
+    lpf_settings prev = apply_context(ctx);
+    size_t sa = suffix_array_engine_workspace_size(t);
+    size_t lpf = lpf_workspace_size(t);
+    ensure_workspace(ctx->ws, sa > lpf ? sa : lpf);
+    restore_settings(&prev);
+}
+
+// Bytes of the workspace
+size_t lpf_context_workspace(const lpf_context *ctx) {
+    return ctx->ws->size;
+}
+
+/**
+* @brief The suffix array of t with the engine of the context.
+*
+* @param[in,out] ctx The context.
+* @param[in] t The text.
+* @param[out] sa Output array of t->len words, NULL to allocate it (free it with free).
+*
+* @return Returns the suffix array.
+**/
+idx_t *lpf_context_suffix_array(lpf_context *ctx, const text *t, idx_t *sa) {
+    lpf_settings prev = apply_context(ctx);
+    sa = output_buffer(sa, t->len);
+    suffix_array_engine_ws(ctx->ws, t, sa);
+    restore_settings(&prev);
+    return sa;
+}
+
+/**
+* @brief The permuted LCP array of t (LCP[i] = PLCP[SA[i]]).
+*
+* @param[in,out] ctx The context.
+* @param[in] t The text.
+* @param[in] sa The suffix array of t.
+* @param[out] plcp Output array of t->len words, NULL to allocate it (free it with free).
+*
+* @return Returns the PLCP array.
+**/
+idx_t *lpf_context_plcp(lpf_context *ctx, const text *t, idx_t *sa, idx_t *plcp) {
+    lpf_settings prev = apply_context(ctx);
+    plcp = output_buffer(plcp, t->len);
+    plcp_array_into(t, sa, plcp);
+    restore_settings(&prev);
+    return plcp;
+}
+
+/**
+* @brief The LPF array of t with the algorithm of the context.
+*
+* @param[in,out] ctx The context.
+* @param[in] t The text.
+* @param[out] lpf Output array of t->len words, NULL to allocate it (free it with free).
+* @param[out] prev_occ Output array of t->len words for the previous occurrences (see lpf_array_prev), NULL to skip them.
+*
+* @return Returns the LPF array.
+**/
+idx_t *lpf_context_lpf(lpf_context *ctx, const text *t, idx_t *lpf, idx_t *prev_occ) {
+    lpf_settings prev = apply_context(ctx);
+    lpf = output_buffer(lpf, t->len);
+    lpf_array_prev_ws(ctx->ws, t, lpf, prev_occ);
+    restore_settings(&prev);
+    return lpf;
+}
@@ -0,0 +1,117 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LIBLPF_H
+#define LIBLPF_H
+
+/**
+* Library interface of liblpf.a / liblpf.so. A context keeps the
+* workspace of its calls, so repeated calls on inputs of the same size
+* do not allocate, and the outputs go to buffers of the caller.
+* A context is used by one thread at a time, every thread may have its own.
+*
+* A context sets only the engine, the LPF algorithm and the thread count
+* of its calls. The DC3 merge and radix sort (set_merge_kind,
+* set_radix_kind), the small input cutoffs (set_sa_small_len,
+* set_dc3_cutoff) and the mismatch kernel (set_mismatch_kernel) are
+* process-wide. Set them before any context is used from other threads
+* and do not change them while calls run.
+*
+* This header is the whole interface and includes no other header of the
+* library, the sources include it for the types below.
+**/
+
+// Index type of every array and length. The library is built with 32-bit
+// indices unless it was compiled with -DLPF_INDEX64, define the same for the
+// callers and check lpf_index_bits() == LPF_INDEX_BITS before the first call.
+#ifdef LPF_INDEX64
+typedef int64_t idx_t;
+#define LPF_INDEX_BITS 64
+#else
+typedef int32_t idx_t;
+#define LPF_INDEX_BITS 32
+#endif
+
+/**
+* Width of the symbols of an input text. Byte input is kept as uint8_t,
+* wider alphabets use 16 or 32 bits. SYM_IDX is the width of the index
+* type, it is used for the reduced strings of the DC3/SA-IS recursions.
+**/
+enum SymbolType {
+    SYM_U8,
+    SYM_U16,
+    SYM_U32,
+    SYM_IDX,
+};
+typedef enum SymbolType SymbolType;
+
+struct text {
+    const void *symbols;
+    idx_t len;
+    idx_t alphabet; // Every symbol is in [0, alphabet)
+    SymbolType type;
+};
+typedef struct text text;
+
+enum SAEngine {
+    DC3,
+    SAIS,
+};
+typedef enum SAEngine SAEngine;
+
+enum LPFAlgorithm {
+    LPF_BINODE,
+    LPF_LEAN,
+    LPF_STACK,
+};
+typedef enum LPFAlgorithm LPFAlgorithm;
+
+/**
+* Order preserving map of a text onto the dense letters [0, size).
+* Letter r stands for the symbol letters[r] of the original text,
+* whose symbols were of the given type.
+**/
+struct alphabet_map {
+    uint64_t *letters;
+    idx_t size;
+    SymbolType type;
+};
+typedef struct alphabet_map alphabet_map;
+
+/**
+* Online LPF of an append-only text. Chunks of symbols are appended as
+* they arrive, LPF[i] and PrevOcc[i] become final once the symbol after
+* the longest previous factor at i has arrived (or the stream is
+* finished) and are read in the order of the positions. The text itself
+* is not kept, the suffix automaton of the received symbols is.
+**/
+typedef struct lpf_stream lpf_stream;
+
+typedef struct lpf_context lpf_context;
+
+int lpf_index_bits(void);
+
+text text_init(const void *symbols, idx_t len, SymbolType type, idx_t alphabet);
+
+text compact_alphabet(const void *symbols, idx_t len, SymbolType type, void *out, alphabet_map *map);
+uint64_t alphabet_letter(const alphabet_map *map, idx_t letter);
+void cleanup_alphabet_map(alphabet_map *map);
+
+lpf_context *lpf_context_create(SAEngine engine, LPFAlgorithm algorithm, int threads);
+void lpf_context_free(lpf_context *ctx);
+void lpf_context_reserve(lpf_context *ctx, const text *t);
+size_t lpf_context_workspace(const lpf_context *ctx);
+idx_t *lpf_context_suffix_array(lpf_context *ctx, const text *t, idx_t *sa);
+idx_t *lpf_context_plcp(lpf_context *ctx, const text *t, idx_t *sa, idx_t *plcp);
+idx_t *lpf_context_lpf(lpf_context *ctx, const text *t, idx_t *lpf, idx_t *prev_occ);
+
+lpf_stream *lpf_stream_create(SymbolType type);
+void lpf_stream_free(lpf_stream *s);
+void lpf_stream_append(lpf_stream *s, const void *symbols, idx_t len);
+void lpf_stream_finish(lpf_stream *s);
+idx_t lpf_stream_read(lpf_stream *s, idx_t *lpf, idx_t *prev_occ, idx_t max);
+idx_t lpf_stream_length(const lpf_stream *s);
+idx_t lpf_stream_final(const lpf_stream *s);
+size_t lpf_stream_memory(const lpf_stream *s);
+
+#endif
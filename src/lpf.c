@@ -1,12 +1,29 @@
 #include "lpf.h"
 #include "lcp.h"
+#include "text.h"
 #include "util.h"
+#include "phase.h"
 #include "tuple.h"
 #include "constants.h"
 #include "suffix_array.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+
+// The settings are per thread, so library contexts (liblpf.c) on different threads do not mix
+static __thread LPFAlgorithm lpf_algorithm = LPF_BINODE;
+
+static idx_t *lpf_binode_ws(workspace *ws, const text *t, idx_t *lpf, idx_t *prev_occ);
+static size_t binode_workspace_size(const text *t);
+
+// Workspace of the selected algorithm, the lean one needs less without PrevOcc
+static size_t algorithm_workspace_size(const text *t, int prev_occ) {
+    if (lpf_algorithm == LPF_LEAN) {
+        return lpf_lean_workspace_size(t, prev_occ);
+    }
+    return lpf_workspace_size(t);
+}
 
 /**
 * @brief Create a helper table for the LPF algorithm.
@@ -23,30 +40,25 @@
 * If we remove entry SA[i] 0 < i < len(SA) then the value
 * of LCP[i+1] should now reflect the LCP of SA[i-1] and SA[i+1].
 *
+* The LCP values are read from PLCP (LCP[i] = PLCP[SA[i]]) so the
+* LCP array in SA order is never materialized.
 *   
-* @param[in] lcp The LCP array.
-* @param[in] len Length of the LCP array.
+* @param[out] adj Output array of size len.
+* @param[in] plcp The PLCP array.
+* @param[in] sa The suffix array.
+* @param[in] len Length of the arrays.
 *
 * @return Returns the LCP tracking/helper array.
 **/
-binode *create_adjacent(int *lcp, int len) {
-    binode *adj = malloc(len * sizeof(binode));
-
-    adj[0].prev = -1;
-    adj[0].prev_val = 0;
-    adj[0].next = 1;
-    adj[0].next_val = lcp[1];
+binode *create_adjacent(binode *adj, idx_t *plcp, idx_t *sa, idx_t len) {
+    idx_t lcp = 0;
 
-    adj[len-1].prev = len-2;
-    adj[len-1].prev_val = lcp[len-1];
-    adj[len-1].next = -1;
-    adj[len-1].next_val = 0;
-
-    for (int i = 1; i < len-1; i++) {
+    for (idx_t i = 0; i < len; i++) {
         adj[i].prev = i-1;
-        adj[i].prev_val = lcp[i];
-        adj[i].next = i+1;
-        adj[i].next_val = lcp[i+1];
+        adj[i].prev_val = lcp;
+        lcp = i+1 < len ? plcp[sa[i+1]] : 0;
+        adj[i].next = i+1 < len ? i+1 : -1;
+        adj[i].next_val = lcp;
     }
 
     return adj;
@@ -69,30 +81,185 @@ binode *create_adjacent(int *lcp, int len) {
 * operation. LCP of SA[i-1] and SA[i+1] is:
 * min(LCP[i], LCP[i+1])
 *   
-* @param[in] str Input text.
-* @param[in] str_len Length of text.
+* @param[in] t Input text.
 *
 * @return Returns the LPF array.
 **/
-int *lpf_array(int *str, int str_len) {
-    int *sa = suffix_array(str, str_len);
-    int *sar = reverse_array(sa, str_len);
-    int *lcp = lcp_array(str, sa, sar,str_len);  
-    int *lpf = calloc(str_len, sizeof(int));
-    binode *adj = create_adjacent(lcp, str_len);
+idx_t *lpf_array(const text *t) {
+    workspace *ws = create_workspace(algorithm_workspace_size(t, 0));
+    idx_t *lpf = mem_alloc(t->len * sizeof(idx_t));
+
+    lpf_array_ws(ws, t, lpf);
 
-    LOG_FUNC(print_suffix_array, str, sa, str_len);
+    cleanup_workspace(ws);
+    return lpf;
+}
+
+/**
+* @brief Create the LPF table together with the previous occurrence of every factor.
+*
+* PrevOcc[i] is a position j < i with w[j...j+LPF[i]-1] = w[i...i+LPF[i]-1]
+* (-1 if LPF[i] = 0). Both arrays come from the same binode pass.
+*
+* @param[in] t Input text.
+* @param[out] prev_occ Set to the PrevOcc array (free it with free).
+*
+* @return Returns the LPF array.
+**/
+idx_t *lpf_array_prev(const text *t, idx_t **prev_occ) {
+    workspace *ws = create_workspace(algorithm_workspace_size(t, 1));
+    idx_t *lpf = mem_alloc(t->len * sizeof(idx_t));
+    *prev_occ = mem_alloc(t->len * sizeof(idx_t));
+
+    lpf_array_prev_ws(ws, t, lpf, *prev_occ);
+
+    cleanup_workspace(ws);
+    return lpf;
+}
+
+/**
+* @brief Create the LPF table (and PrevOcc) and time the phases of the selected algorithm.
+*
+* The phase timers (phase.h) are on during the call, stats receives
+* the time of the suffix array steps, LCP, SA^-1, the node table and the
+* LPF loop.
+*
+* @param[in] t Input text.
+* @param[out] prev_occ Set to the PrevOcc array (free it with free), NULL to skip it.
+* @param[out] stats The phases of the call.
+*
+* @return Returns the LPF array.
+**/
+idx_t *lpf_array_profile(const text *t, idx_t **prev_occ, phase_stats *stats) {
+    int timing = get_phase_timing();
+    set_phase_timing(1);
+    reset_phase_stats();
+
+    idx_t *lpf = prev_occ != NULL ? lpf_array_prev(t, prev_occ) : lpf_array(t);
+
+    get_phase_stats(stats);
+    set_phase_timing(timing);
+    return lpf;
+}
+
+/**
+* @brief Workspace needed by lpf_array_ws with the selected algorithm.
+* For the lean algorithm the size with PrevOcc is returned.
+**/
+size_t lpf_workspace_size(const text *t) {
+    switch (lpf_algorithm) {
+        case LPF_LEAN:
+            return lpf_lean_workspace_size(t, 1);
+        case LPF_STACK:
+            return lpf_stack_workspace_size(t);
+        case LPF_BINODE:
+        default:
+            return binode_workspace_size(t);
+    }
+}
+
+// SA, PLCP (reused for SA^-1) and the binode table on top of the suffix array construction
+static size_t binode_workspace_size(const text *t) {
+    size_t sa = WS_SIZE(t->len * sizeof(idx_t));
+    size_t sa_construction = suffix_array_engine_workspace_size(t);
+    size_t lpf_phase = WS_SIZE(t->len * sizeof(idx_t)) + WS_SIZE(t->len * sizeof(binode));
+
+    return sa + (sa_construction > lpf_phase ? sa_construction : lpf_phase);
+}
+
+/**
+* @brief Create the longest previous substring table using a workspace.
+*
+* Same as lpf_array but all temporary arrays (including the ones of the
+* suffix array construction) come from ws and the result is written to lpf.
+* Reusing the workspace for inputs of the same size needs no heap allocations.
+*
+* @param[in,out] ws The workspace.
+* @param[in] t Input text.
+* @param[out] lpf Output array of size t->len.
+*
+* @return Returns lpf.
+**/
+idx_t *lpf_array_ws(workspace *ws, const text *t, idx_t *lpf) {
+    return lpf_array_prev_ws(ws, t, lpf, NULL);
+}
+
+/**
+* @brief Create the LPF table and the position of a previous occurrence of every factor.
+*
+* The neighbour which gives LPF[i] in the binode pass is a suffix j < i
+* (every suffix after i was already removed), so SA of that neighbour
+* is a source of the longest previous factor at no extra cost.
+* On a tie the lexicographically smaller neighbour is used.
+* The pass runs on the binode table unless set_lpf_algorithm selected
+* the lean table (lpf_array_lean_ws) or the stack scan (lpf_array_stack_ws).
+*
+* @param[in,out] ws The workspace.
+* @param[in] t Input text.
+* @param[out] lpf Output array of size t->len.
+* @param[out] prev_occ Output array of size t->len (or NULL), prev_occ[i] = -1 if lpf[i] = 0.
+*
+* @return Returns lpf.
+**/
+idx_t *lpf_array_prev_ws(workspace *ws, const text *t, idx_t *lpf, idx_t *prev_occ) {
+    switch (lpf_algorithm) {
+        case LPF_LEAN:
+            return lpf_array_lean_ws(ws, t, lpf, prev_occ);
+        case LPF_STACK:
+            return lpf_array_stack_ws(ws, t, lpf, prev_occ);
+        case LPF_BINODE:
+        default:
+            return lpf_binode_ws(ws, t, lpf, prev_occ);
+    }
+}
+
+static idx_t *lpf_binode_ws(workspace *ws, const text *t, idx_t *lpf, idx_t *prev_occ) {
+    idx_t str_len = t->len;
+    if (str_len <= 1) {
+        if (str_len == 1) {
+            lpf[0] = 0;
+            if (prev_occ != NULL) {
+                prev_occ[0] = -1;
+            }
+        }
+        return lpf;
+    }
+    ensure_workspace(ws, binode_workspace_size(t));
+    size_t mark = ws_mark(ws);
+
+    phase_begin(PHASE_SA);
+    idx_t *sa = suffix_array_engine_ws(ws, t, ws_alloc(ws, str_len * sizeof(idx_t)));
+    phase_end(PHASE_SA);
+    phase_begin(PHASE_LCP);
+    idx_t *plcp = plcp_array_into(t, sa, ws_alloc(ws, str_len * sizeof(idx_t)));
+    phase_end(PHASE_LCP);
+    phase_begin(PHASE_BINODE);
+    binode *adj = create_adjacent(ws_alloc(ws, str_len * sizeof(binode)), plcp, sa, str_len);
+    phase_end(PHASE_BINODE);
+
+    LOG_FUNC(printf_line, plcp, str_len, NULL);
+
+    // The binodes hold every LCP value, PLCP is overwritten with SA^-1
+    phase_begin(PHASE_ISA);
+    idx_t *sar = reverse_array_into(sa, str_len, plcp);
+    phase_end(PHASE_ISA);
+    phase_begin(PHASE_LPF);
+
+    lpf[0] = 0;
+    if (prev_occ != NULL) {
+        prev_occ[0] = -1;
+    }
+
+    LOG_FUNC(print_suffix_array, t, sa);
 
     LOG_FUNC(printf_line, sa, str_len);
     LOG_FUNC(printf_line, sar, str_len);
-    LOG_FUNC(printf_line, lcp, str_len);
 
     // print_suffix_array(str, sa, str_len);
-    // printf_array(lcp, str_len);
 
-    int index, prev, next, prev_val, next_val;
+    idx_t index, prev, next, prev_val, next_val, src;
 
-    for (int i = str_len-1; i > 0; i--) {
+    for (idx_t i = str_len-1; i > 0; i--) {
         index = sar[i];
         prev = adj[index].prev;
         next = adj[index].next;
@@ -103,8 +270,13 @@ int *lpf_array(int *str, int str_len) {
 
         if (prev_val < next_val) {
             lpf[i] = next_val;
+            src = next;
         } else {
             lpf[i] = prev_val;
+            src = prev;
+        }
+        if (prev_occ != NULL) {
+            prev_occ[i] = lpf[i] > 0 ? sa[src] : -1;
         }
 
         if (next >= 0) {
@@ -116,34 +288,80 @@ int *lpf_array(int *str, int str_len) {
             adj[prev].next_val = next > 0 ? adj[next].prev_val : 0;
         }
     }
-    free(sa);
-    free(sar);
-    free(lcp);
-    free(adj);
+    phase_end(PHASE_LPF);
+    ws_release(ws, mark);
+    return lpf;
+}
+
+/**
+* @brief The LPF table of the binode pass whatever algorithm is selected,
+* the reference of the LPF benchmark for the other algorithms.
+**/
+idx_t *lpf_array_binode(const text *t) {
+    workspace *ws = create_workspace(binode_workspace_size(t));
+    idx_t *lpf = mem_alloc(t->len * sizeof(idx_t));
+
+    lpf_binode_ws(ws, t, lpf, NULL);
 
+    cleanup_workspace(ws);
     return lpf;
 }
 
 // Used to validate the lpf algorithm
-int *lpf_array_naive(int *str, int str_len) {
-    int *lpf = calloc(str_len, sizeof(int));
-    int max, pmax;
+idx_t *lpf_array_naive(const text *t) {
+    idx_t str_len = t->len;
+    idx_t *lpf = mem_calloc(str_len, sizeof(idx_t));
+    idx_t max, pmax;
 
-    for (int i = 0; i < str_len; i++) {
+    for (idx_t i = 0; i < str_len; i++) {
         max = 0;
-        for (int j = i-1; j >= 0; j--) {
-            pmax = 0;
-            for (int len = 0; len < str_len - i; len++) {
-                if (str[i+len] == str[j+len]) {
-                    pmax++;
-                } else {
-                    break;
-                }
-            }
+        for (idx_t j = i-1; j >= 0; j--) {
+            pmax = text_match(t, i, j, str_len - i);
             max = max < pmax ? pmax : max;
         }
         lpf[i] = max;
     }
 
     return lpf;
-}
\ No newline at end of file
+}
+
+void set_lpf_algorithm(LPFAlgorithm alg) {
+    lpf_algorithm = alg;
+}
+
+LPFAlgorithm get_lpf_algorithm() {
+    return lpf_algorithm;
+}
+
+const char *lpf_algorithm_name(LPFAlgorithm alg) {
+    switch (alg) {
+        case LPF_LEAN:
+            return "lean";
+        case LPF_STACK:
+            return "stack";
+        case LPF_BINODE:
+        default:
+            return "binode";
+    }
+}
+
+/**
+* @brief Parse the LPF algorithm name ("binode", "lean" or "stack").
+*
+* @return Returns 1 if the name was recognized, 0 otherwise.
+**/
+int parse_lpf_algorithm(const char *name, LPFAlgorithm *alg) {
+    if (!strcmp(name, "binode")) {
+        *alg = LPF_BINODE;
+        return 1;
+    }
+    if (!strcmp(name, "lean")) {
+        *alg = LPF_LEAN;
+        return 1;
+    }
+    if (!strcmp(name, "stack")) {
+        *alg = LPF_STACK;
+        return 1;
+    }
+    return 0;
+}
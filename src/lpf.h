@@ -1,15 +1,35 @@
+#include "constants.h"
+#include "workspace.h"
+#include "text.h"
+#include "phase.h"
+
 #ifndef LPF_H
 #define LPF_H
 
 struct binode {
-    int prev;
-    int next;
-    int prev_val;
-    int next_val;
+    idx_t prev;
+    idx_t next;
+    idx_t prev_val;
+    idx_t next_val;
 };
 typedef struct binode binode;
 
-int *lpf_array(int *str, int str_len);
-int *lpf_array_naive(int *str, int str_len);
+idx_t *lpf_array(const text *t);
+idx_t *lpf_array_prev(const text *t, idx_t **prev_occ);
+idx_t *lpf_array_profile(const text *t, idx_t **prev_occ, phase_stats *stats);
+idx_t *lpf_array_ws(workspace *ws, const text *t, idx_t *lpf);
+idx_t *lpf_array_prev_ws(workspace *ws, const text *t, idx_t *lpf, idx_t *prev_occ);
+size_t lpf_workspace_size(const text *t);
+idx_t *lpf_array_lean_ws(workspace *ws, const text *t, idx_t *lpf, idx_t *prev_occ);
+size_t lpf_lean_workspace_size(const text *t, int prev_occ);
+size_t lpf_lean_bound(const text *t, int prev_occ);
+idx_t *lpf_array_stack_ws(workspace *ws, const text *t, idx_t *lpf, idx_t *prev_occ);
+size_t lpf_stack_workspace_size(const text *t);
+idx_t *lpf_array_binode(const text *t);
+void set_lpf_algorithm(LPFAlgorithm alg);
+LPFAlgorithm get_lpf_algorithm();
+const char *lpf_algorithm_name(LPFAlgorithm alg);
+int parse_lpf_algorithm(const char *name, LPFAlgorithm *alg);
+idx_t *lpf_array_naive(const text *t);
 
 #endif
\ No newline at end of file
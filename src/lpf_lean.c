@@ -0,0 +1,193 @@
+#include "lpf.h"
+#include "lcp.h"
+#include "phase.h"
+#include "sais.h"
+#include "text.h"
+#include "constants.h"
+#include "workspace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+// A node of the lean table is 3 consecutive words: prev, next and prev_val
+#define NODE(table, i) ((table) + 3 * (size_t)(i))
+#define NODE_PREV 0
+#define NODE_NEXT 1
+#define NODE_VAL 2
+
+/**
+* @brief Workspace needed by lpf_array_lean_ws.
+*
+* The suffix array is built with SA-IS in the first n words, the
+* remaining 2n words of the node table are taken after it. With PrevOcc
+* a copy of SA is kept on top.
+*
+* @param[in] t Input text.
+* @param[in] prev_occ Nonzero if PrevOcc is computed.
+**/
+size_t lpf_lean_workspace_size(const text *t, int prev_occ) {
+    if (t->len <= 1) {
+        return 0;
+    }
+    size_t sa = WS_SIZE(t->len * sizeof(idx_t));
+    size_t sa_phase = sa + suffix_array_sais_workspace_size(t);
+    size_t lpf_phase = sa + WS_SIZE(2 * (size_t)t->len * sizeof(idx_t)) + (prev_occ ? sa : 0);
+
+    return sa_phase > lpf_phase ? sa_phase : lpf_phase;
+}
+
+// Workspace allocations alive at once: SA and two per SA-IS level, or SA, the rest of the table and the copy of SA
+static size_t lean_allocations(idx_t len, int prev_occ) {
+    size_t sais = 1;
+    for (idx_t n = len; n > 1; n = (n - 1) / 2) {
+        sais += 2;
+    }
+    size_t lpf = 2 + (prev_occ ? 1 : 0);
+    return sais > lpf ? sais : lpf;
+}
+
+/**
+* @brief The documented peak of the lean LPF workspace.
+*
+* LPF_LEAN_WORDS words per symbol (one more with PrevOcc) plus a word
+* per letter of the alphabet, and up to WORKSPACE_ALIGNMENT bytes of
+* padding for each allocation alive at once. The LPF and PrevOcc
+* outputs are not included.
+**/
+size_t lpf_lean_bound(const text *t, int prev_occ) {
+    size_t words = (size_t)(LPF_LEAN_WORDS + (prev_occ ? 1 : 0)) * t->len + t->alphabet;
+    return words * sizeof(idx_t) + lean_allocations(t->len, prev_occ) * WORKSPACE_ALIGNMENT;
+}
+
+/**
+* @brief Create the LPF table (and PrevOcc) in a bounded amount of memory.
+*
+* Same result as lpf_array_prev_ws but every buffer is reused in place:
+*  - SA (SA-IS, whose temporaries fit below the bound) is extended to
+*    a table of 3n words and PLCP is built in its second third,
+*  - SA^-1 is written to lpf, entry i is read just before LPF[i]
+*    overwrites it,
+*  - LCP overwrites SA (LCP[i] = PLCP[SA[i]]) and is spread from the
+*    back into nodes {prev, next, prev_val}. The LCP with the next
+*    node is the prev_val of the next node so it is not stored.
+*
+* The allocations of the call never take more than lpf_lean_bound(t)
+* bytes of the workspace, an internal error is raised otherwise (before
+* the run from the size estimate, after it from the peak of the call).
+* A larger arena which ws already had (a reused context) is kept by
+* ensure_workspace and is not part of the bound. Without PrevOcc that is about
+* LPF_LEAN_WORDS words per symbol, the binode table alone needs 4.
+* The nodes are removed in the same order as the binode pass.
+*
+* @param[in,out] ws The workspace.
+* @param[in] t Input text.
+* @param[out] lpf Output array of size t->len.
+* @param[out] prev_occ Output array of size t->len (or NULL).
+*
+* @return Returns lpf.
+**/
+idx_t *lpf_array_lean_ws(workspace *ws, const text *t, idx_t *lpf, idx_t *prev_occ) {
+    idx_t str_len = t->len;
+    if (str_len <= 1) {
+        if (str_len == 1) {
+            lpf[0] = 0;
+            if (prev_occ != NULL) {
+                prev_occ[0] = -1;
+            }
+        }
+        return lpf;
+    }
+    size_t size = lpf_lean_workspace_size(t, prev_occ != NULL);
+    if (size > lpf_lean_bound(t, prev_occ != NULL)) {
+        fprintf(stderr, "Lean LPF needs %zu bytes, above its bound of %zu bytes\n", size, lpf_lean_bound(t, prev_occ != NULL));
+        abort();
+    }
+    ensure_workspace(ws, size);
+    size_t mark = ws_mark(ws);
+    // The peak of this call alone, the one before it is restored at the end
+    size_t peak = ws->peak;
+    ws->peak = mark;
+
+    phase_begin(PHASE_SA);
+    idx_t *table = suffix_array_sais_ws(ws, t, ws_alloc(ws, str_len * sizeof(idx_t)));
+    phase_end(PHASE_SA);
+    char *tail = ws_alloc(ws, 2 * (size_t)str_len * sizeof(idx_t));
+    if (tail != (char *)table + WS_SIZE(str_len * sizeof(idx_t))) {
+        fprintf(stderr, "Lean LPF table is not contiguous\n");
+        abort();
+    }
+
+    idx_t *sa = table;
+    if (prev_occ != NULL) {
+        sa = memcpy(ws_alloc(ws, str_len * sizeof(idx_t)), table, str_len * sizeof(idx_t));
+    }
+
+    phase_begin(PHASE_LCP);
+    idx_t *plcp = plcp_array_into(t, table, table + str_len);
+    phase_end(PHASE_LCP);
+    phase_begin(PHASE_ISA);
+    idx_t *sar = reverse_array_into(table, str_len, lpf);
+    phase_end(PHASE_ISA);
+
+    phase_begin(PHASE_LCP);
+    for (idx_t i = 0; i < str_len; i++) {
+        table[i] = plcp[table[i]];
+    }
+    phase_end(PHASE_LCP);
+    phase_begin(PHASE_BINODE);
+    // Node i takes words 3i...3i+2, going backwards LCP[i] is read before it is overwritten
+    for (idx_t i = str_len-1; i >= 0; i--) {
+        idx_t *node = NODE(table, i);
+        idx_t lcp = table[i];
+        node[NODE_PREV] = i-1;
+        node[NODE_NEXT] = i+1 < str_len ? i+1 : -1;
+        node[NODE_VAL] = lcp;
+    }
+    phase_end(PHASE_BINODE);
+    phase_begin(PHASE_LPF);
+
+    idx_t index, prev, next, prev_val, next_val, src;
+
+    for (idx_t i = str_len-1; i > 0; i--) {
+        index = sar[i];
+        idx_t *node = NODE(table, index);
+        prev = node[NODE_PREV];
+        next = node[NODE_NEXT];
+        prev_val = node[NODE_VAL];
+        next_val = next >= 0 ? NODE(table, next)[NODE_VAL] : 0;
+
+        if (prev_val < next_val) {
+            lpf[i] = next_val;
+            src = next;
+        } else {
+            lpf[i] = prev_val;
+            src = prev;
+        }
+        if (prev_occ != NULL) {
+            prev_occ[i] = lpf[i] > 0 ? sa[src] : -1;
+        }
+
+        if (next >= 0) {
+            NODE(table, next)[NODE_PREV] = prev;
+            NODE(table, next)[NODE_VAL] = next_val > prev_val ? prev_val : next_val;
+        }
+        if (prev >= 0) {
+            NODE(table, prev)[NODE_NEXT] = next;
+        }
+    }
+
+    lpf[0] = 0;
+    if (prev_occ != NULL) {
+        prev_occ[0] = -1;
+    }
+    phase_end(PHASE_LPF);
+    size_t used = ws->peak - mark;
+    ws->peak = peak > ws->peak ? peak : ws->peak;
+    if (used > lpf_lean_bound(t, prev_occ != NULL)) {
+        fprintf(stderr, "Lean LPF used %zu bytes, above its bound of %zu bytes\n", used, lpf_lean_bound(t, prev_occ != NULL));
+        abort();
+    }
+    ws_release(ws, mark);
+    return lpf;
+}
@@ -0,0 +1,261 @@
+#include "lpf.h"
+#include "lcp.h"
+#include "phase.h"
+#include "text.h"
+#include "constants.h"
+#include "parallel.h"
+#include "workspace.h"
+#include "suffix_array.h"
+
+// A suffix on the stack and its LCP with the suffix below it
+struct stack_entry {
+    idx_t pos;
+    idx_t lcp;
+};
+typedef struct stack_entry stack_entry;
+
+/**
+* @brief Workspace needed by lpf_array_stack_ws: SA, PLCP and the stack
+* on top of the suffix array construction.
+**/
+size_t lpf_stack_workspace_size(const text *t) {
+    size_t sa = WS_SIZE(t->len * sizeof(idx_t));
+    size_t sa_construction = suffix_array_engine_workspace_size(t);
+    size_t lpf_phase = WS_SIZE(t->len * sizeof(idx_t)) + WS_SIZE(t->len * sizeof(stack_entry));
+
+    return sa + (sa_construction > lpf_phase ? sa_construction : lpf_phase);
+}
+
+struct stack_job {
+    const idx_t *sa;
+    const idx_t *plcp;
+    idx_t *lpf;
+    idx_t *prev_occ;
+    stack_entry *stack;
+    idx_t len;
+    // Smallest suffix and smallest LCP of every block
+    idx_t sa_min[MAX_THREADS];
+    idx_t lcp_min[MAX_THREADS];
+};
+typedef struct stack_job stack_job;
+
+#define LCP_AT(job, r) ((job)->plcp[(job)->sa[r]])
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// Scan of one block of SA with its own part of the stack
+static void stack_block(void *arg, int id, int chunks) {
+    stack_job *job = arg;
+    const idx_t *sa = job->sa;
+    idx_t *lpf = job->lpf;
+    idx_t *prev_occ = job->prev_occ;
+    idx_t from = chunk_begin(job->len, id, chunks);
+    idx_t to = chunk_begin(job->len, id+1, chunks);
+    stack_entry *stack = job->stack + from;
+    idx_t top = -1, sa_min = IDX_MAX, lcp_min = IDX_MAX;
+
+    for (idx_t r = from; r < to; r++) {
+        idx_t pos = sa[r];
+        idx_t lcp = LCP_AT(job, r);
+        sa_min = MIN(sa_min, pos);
+        lcp_min = MIN(lcp_min, lcp);
+
+        // r is the next smaller value of every popped suffix
+        while (top >= 0 && stack[top].pos > pos) {
+            idx_t popped = stack[top].pos;
+            if (lcp > lpf[popped]) {
+                lpf[popped] = lcp;
+                if (prev_occ != NULL) {
+                    prev_occ[popped] = pos;
+                }
+            }
+            if (stack[top].lcp < lcp) {
+                lcp = stack[top].lcp;
+            }
+            top--;
+        }
+
+        // The top is the previous smaller value of r, it wins ties
+        if (top < 0) {
+            lcp = 0;
+        }
+        lpf[pos] = lcp;
+        if (prev_occ != NULL) {
+            prev_occ[pos] = lcp > 0 ? stack[top].pos : -1;
+        }
+
+        top++;
+        stack[top].pos = pos;
+        stack[top].lcp = lcp;
+    }
+    job->sa_min[id] = sa_min;
+    job->lcp_min[id] = lcp_min;
+}
+
+/*
+* The suffixes whose previous smaller value lies before the block are the
+* left to right minima of the block. Going right they get smaller so
+* their previous smaller values move left: one pointer j walks back over
+* the earlier blocks (skipping a whole block if its minimum is larger)
+* and min LCP[j+1...from-1] is kept along the way.
+*/
+static void resolve_prev(stack_job *job, int id, int chunks) {
+    const idx_t *sa = job->sa;
+    idx_t from = chunk_begin(job->len, id, chunks);
+    idx_t to = chunk_begin(job->len, id+1, chunks);
+    idx_t j = from - 1, outside = IDX_MAX, inside = IDX_MAX, min = IDX_MAX;
+    int block = id - 1;
+
+    for (idx_t r = from; r < to; r++) {
+        idx_t pos = sa[r];
+        inside = MIN(inside, LCP_AT(job, r));
+        if (pos > min) {
+            continue;
+        }
+        min = pos;
+
+        while (j >= 0 && sa[j] > pos) {
+            idx_t begin = chunk_begin(job->len, block, chunks);
+            if (j == chunk_begin(job->len, block+1, chunks) - 1 && job->sa_min[block] > pos) {
+                outside = MIN(outside, job->lcp_min[block]);
+                j = begin - 1;
+                block--;
+            } else {
+                outside = MIN(outside, LCP_AT(job, j));
+                j--;
+                if (j < begin) {
+                    block--;
+                }
+            }
+        }
+        if (j < 0) {
+            return;
+        }
+
+        idx_t lcp = MIN(outside, inside);
+        if (lcp >= job->lpf[pos]) {
+            job->lpf[pos] = lcp;
+            if (job->prev_occ != NULL) {
+                job->prev_occ[pos] = lcp > 0 ? sa[j] : -1;
+            }
+        }
+    }
+}
+
+// The mirror image for the right to left minima (left on the stack of the block)
+static void resolve_next(stack_job *job, int id, int chunks) {
+    const idx_t *sa = job->sa;
+    idx_t from = chunk_begin(job->len, id, chunks);
+    idx_t to = chunk_begin(job->len, id+1, chunks);
+    idx_t j = to, outside = IDX_MAX, inside = IDX_MAX, min = IDX_MAX;
+    int block = id + 1;
+
+    for (idx_t r = to-1; r >= from; r--) {
+        idx_t pos = sa[r];
+        if (pos < min) {
+            min = pos;
+
+            while (j < job->len && sa[j] > pos) {
+                idx_t end = chunk_begin(job->len, block+1, chunks);
+                if (j == chunk_begin(job->len, block, chunks) && job->sa_min[block] > pos) {
+                    outside = MIN(outside, job->lcp_min[block]);
+                    j = end;
+                    block++;
+                } else {
+                    outside = MIN(outside, LCP_AT(job, j));
+                    j++;
+                    if (j >= end) {
+                        block++;
+                    }
+                }
+            }
+            if (j >= job->len) {
+                return;
+            }
+
+            idx_t lcp = MIN(inside, MIN(outside, LCP_AT(job, j)));
+            if (lcp > job->lpf[pos]) {
+                job->lpf[pos] = lcp;
+                if (job->prev_occ != NULL) {
+                    job->prev_occ[pos] = sa[j];
+                }
+            }
+        }
+        inside = MIN(inside, LCP_AT(job, r));
+    }
+}
+
+static void stack_resolve(void *arg, int id, int chunks) {
+    stack_job *job = arg;
+
+    if (id > 0) {
+        resolve_prev(job, id, chunks);
+    }
+    if (id < chunks-1) {
+        resolve_next(job, id, chunks);
+    }
+}
+
+/**
+* @brief Create the LPF table (and PrevOcc) with one scan over the suffix array.
+*
+* This is the algorithm of Crochemore and Ilie
+* (https://doi.org/10.1016/j.ipl.2008.10.001): LPF[SA[r]] is the larger
+* LCP of rank r with its previous and next smaller value in SA, the
+* closest ranks which start before SA[r]. These are exactly the
+* neighbours of the binode pass.
+*
+* SA is scanned in order with a stack of suffixes whose positions
+* increase towards the top. The top is the previous smaller value of
+* the current rank, every suffix popped by it has it as the next
+* smaller value. The stack stores the LCP of every entry with the one
+* below it, so the range minimum of LCP between the two values is
+* accumulated while popping instead of queried.
+*
+* With more than one thread SA is split into blocks which are scanned
+* in parallel. Only the left to right minima of a block (no previous
+* smaller value inside) and the right to left minima (no next smaller
+* value inside) are left, they are resolved in a second parallel pass
+* with the minimum suffix and LCP of every block as the range minimum
+* structure.
+*
+* SA and LCP are read sequentially, only the results are written out of
+* order. The output (PrevOcc and ties included) equals the binode pass.
+*
+* @param[in,out] ws The workspace.
+* @param[in] t Input text.
+* @param[out] lpf Output array of size t->len.
+* @param[out] prev_occ Output array of size t->len (or NULL).
+*
+* @return Returns lpf.
+**/
+idx_t *lpf_array_stack_ws(workspace *ws, const text *t, idx_t *lpf, idx_t *prev_occ) {
+    idx_t str_len = t->len;
+    if (str_len == 0) {
+        return lpf;
+    }
+    ensure_workspace(ws, lpf_stack_workspace_size(t));
+    size_t mark = ws_mark(ws);
+
+    stack_job job;
+    phase_begin(PHASE_SA);
+    job.sa = suffix_array_engine_ws(ws, t, ws_alloc(ws, str_len * sizeof(idx_t)));
+    phase_end(PHASE_SA);
+    phase_begin(PHASE_LCP);
+    job.plcp = plcp_array_into(t, (idx_t *)job.sa, ws_alloc(ws, str_len * sizeof(idx_t)));
+    phase_end(PHASE_LCP);
+    phase_begin(PHASE_LPF);
+    job.stack = ws_alloc(ws, str_len * sizeof(stack_entry));
+    job.lpf = lpf;
+    job.prev_occ = prev_occ;
+    job.len = str_len;
+
+    int chunks = parallel_chunks(str_len);
+    parallel_run(stack_block, &job, chunks);
+    if (chunks > 1) {
+        parallel_run(stack_resolve, &job, chunks);
+    }
+    phase_end(PHASE_LPF);
+
+    ws_release(ws, mark);
+    return lpf;
+}
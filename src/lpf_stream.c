@@ -0,0 +1,386 @@
+#include "liblpf.h"
+#include "text.h"
+#include "workspace.h"
+#include "constants.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/*
+* Most states have a single outgoing edge, it is kept in the state and
+* only the further edges go to the hash table. Symbols are compared only,
+* so they are kept as idx_t (32-bit symbols wrap in the 32-bit build).
+*/
+struct sam_state {
+    idx_t len;          // Of the longest string of the state
+    idx_t link;         // Suffix link, -1 at the root
+    idx_t first_end;    // End of the first occurrence of its strings
+    idx_t sym, to;      // The first edge, to is -1 if the state has none
+    idx_t edges;        // First hashed edge, -1 if none
+};
+typedef struct sam_state sam_state;
+
+struct sam_edge {
+    idx_t sym;
+    idx_t from;
+    idx_t to;
+    idx_t next;         // The next hashed edge of from
+};
+typedef struct sam_edge sam_edge;
+
+/*
+* The suffix automaton holds text[0...pos+match) and the current match
+* text[pos...pos+match) is state, it occurs before pos as well. The
+* hashed edges are listed per state (for cloning) and found through an
+* open addressing table of edge indices (-1 is empty) keyed by (from, sym).
+* A table which doubles keeps the previous one until STREAM_REHASH_STEP
+* edges per insertion have moved, no append waits for a whole rehash.
+*/
+struct lpf_stream {
+    SymbolType type;
+    sam_state *states;
+    idx_t state_count, state_cap;
+    sam_edge *edges;
+    idx_t edge_count, edge_cap;
+    idx_t *slots;
+    int slot_bits;
+    idx_t *old_slots;   // The table before the last growth, NULL once its edges moved
+    int old_bits;
+    idx_t moved, old_count;  // Edges [moved, old_count) are only in old_slots
+    idx_t last;         // The state of the whole text
+    idx_t state, pos, match;
+    idx_t received;
+    idx_t *out_lpf, *out_prev;  // Final values not read yet, out_lpf[out_start...out_len-1]
+    idx_t out_start, out_len, out_cap;
+    int finished;
+};
+
+// Doubles the capacity of arr (elements of size bytes) until it holds need elements
+static void *grow(void *arr, idx_t *cap, idx_t need, size_t size) {
+    if (need <= *cap) {
+        return arr;
+    }
+    idx_t next_cap = *cap > 0 ? *cap : STREAM_MIN_CAPACITY;
+    while (next_cap < need) {
+        next_cap *= 2;
+    }
+    arr = mem_realloc(arr, (size_t)*cap * size, (size_t)next_cap * size);
+    *cap = next_cap;
+    return arr;
+}
+
+static inline size_t edge_slot(idx_t from, idx_t sym, int bits) {
+    uint64_t key = (uint64_t)from * 0x9E3779B97F4A7C15ULL ^ (uint64_t)sym * 0xC2B2AE3D27D4EB4FULL;
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+// The slot of the edge (from, sym) in a table of 2^bits slots or the empty slot where it belongs
+static inline size_t find_slot(const lpf_stream *s, const idx_t *slots, int bits, idx_t from, idx_t sym) {
+    size_t mask = ((size_t)1 << bits) - 1;
+    size_t h = edge_slot(from, sym, bits);
+    while (slots[h] >= 0) {
+        const sam_edge *e = &s->edges[slots[h]];
+        if (e->from == from && e->sym == sym) {
+            break;
+        }
+        h = (h + 1) & mask;
+    }
+    return h;
+}
+
+// Where the target of the edge (from, sym) is stored, NULL if there is no such edge
+static inline idx_t *edge_ref(lpf_stream *s, idx_t from, idx_t sym) {
+    sam_state *st = &s->states[from];
+    if (st->to >= 0 && st->sym == sym) {
+        return &st->to;
+    }
+    if (st->edges < 0) {
+        return NULL;
+    }
+    idx_t e = s->slots[find_slot(s, s->slots, s->slot_bits, from, sym)];
+    if (e < 0 && s->old_slots != NULL) {
+        e = s->old_slots[find_slot(s, s->old_slots, s->old_bits, from, sym)];
+    }
+    return e >= 0 ? &s->edges[e].to : NULL;
+}
+
+static inline idx_t edge_target(lpf_stream *s, idx_t from, idx_t sym) {
+    idx_t *to = edge_ref(s, from, sym);
+    return to != NULL ? *to : -1;
+}
+
+static inline void insert_slot(lpf_stream *s, idx_t e) {
+    s->slots[find_slot(s, s->slots, s->slot_bits, s->edges[e].from, s->edges[e].sym)] = e;
+}
+
+// Moves up to count edges of the previous table to the current one
+static void move_edges(lpf_stream *s, idx_t count) {
+    if (s->old_slots == NULL) {
+        return;
+    }
+    for (; count > 0 && s->moved < s->old_count; count--) {
+        insert_slot(s, s->moved++);
+    }
+    if (s->moved == s->old_count) {
+        mem_free(s->old_slots, ((size_t)1 << s->old_bits) * sizeof(idx_t));
+        s->old_slots = NULL;
+    }
+}
+
+// Starts a table with twice the slots, the edges keep their indices
+static void grow_slots(lpf_stream *s) {
+    move_edges(s, s->edge_count);
+    s->old_slots = s->slots;
+    s->old_bits = s->slot_bits;
+    s->moved = 0;
+    s->old_count = s->edge_count;
+
+    s->slot_bits++;
+    size_t slots = (size_t)1 << s->slot_bits;
+    s->slots = mem_alloc(slots * sizeof(idx_t));
+    memset(s->slots, 0xff, slots * sizeof(idx_t));
+}
+
+static void add_edge(lpf_stream *s, idx_t from, idx_t sym, idx_t to) {
+    if (s->states[from].to < 0) {
+        s->states[from].sym = sym;
+        s->states[from].to = to;
+        return;
+    }
+    s->edges = grow(s->edges, &s->edge_cap, s->edge_count + 1, sizeof(sam_edge));
+    if (2 * ((size_t)s->edge_count + 1) > (size_t)1 << s->slot_bits) {
+        grow_slots(s);
+    }
+    idx_t e = s->edge_count++;
+    s->edges[e].sym = sym;
+    s->edges[e].from = from;
+    s->edges[e].to = to;
+    s->edges[e].next = s->states[from].edges;
+    s->states[from].edges = e;
+    insert_slot(s, e);
+    move_edges(s, STREAM_REHASH_STEP);
+}
+
+static idx_t new_state(lpf_stream *s, idx_t len, idx_t first_end) {
+    s->states = grow(s->states, &s->state_cap, s->state_count + 1, sizeof(sam_state));
+    idx_t id = s->state_count++;
+    s->states[id].len = len;
+    s->states[id].link = -1;
+    s->states[id].first_end = first_end;
+    s->states[id].to = -1;
+    s->states[id].edges = -1;
+    return id;
+}
+
+/**
+* @brief Append one symbol to the suffix automaton (Blumer et al.).
+*
+* A state split by a clone keeps its longer strings, so the current
+* match moves to the clone if it is not longer than the clone.
+**/
+static void sam_extend(lpf_stream *s, idx_t c) {
+    idx_t end = s->states[s->last].len;
+    idx_t cur = new_state(s, end + 1, end);
+    idx_t p = s->last;
+
+    while (p >= 0 && edge_target(s, p, c) < 0) {
+        add_edge(s, p, c, cur);
+        p = s->states[p].link;
+    }
+    if (p < 0) {
+        s->states[cur].link = 0;
+    } else {
+        idx_t q = edge_target(s, p, c);
+        if (s->states[p].len + 1 == s->states[q].len) {
+            s->states[cur].link = q;
+        } else {
+            idx_t clone = new_state(s, s->states[p].len + 1, s->states[q].first_end);
+            s->states[clone].sym = s->states[q].sym;
+            s->states[clone].to = s->states[q].to;
+            for (idx_t e = s->states[q].edges; e >= 0; e = s->edges[e].next) {
+                add_edge(s, clone, s->edges[e].sym, s->edges[e].to);
+            }
+            s->states[clone].link = s->states[q].link;
+            for (; p >= 0 && edge_target(s, p, c) == q; p = s->states[p].link) {
+                *edge_ref(s, p, c) = clone;
+            }
+            s->states[q].link = clone;
+            s->states[cur].link = clone;
+            if (s->state == q && s->match <= s->states[clone].len) {
+                s->state = clone;
+            }
+        }
+    }
+    s->last = cur;
+}
+
+// LPF[pos] is the current match, the match of pos+1 is one symbol shorter
+static void emit(lpf_stream *s) {
+    idx_t cap = s->out_cap;
+    s->out_lpf = grow(s->out_lpf, &cap, s->out_len + 1, sizeof(idx_t));
+    s->out_prev = grow(s->out_prev, &s->out_cap, s->out_len + 1, sizeof(idx_t));
+    s->out_lpf[s->out_len] = s->match;
+    s->out_prev[s->out_len] = s->match > 0 ? s->states[s->state].first_end - s->match + 1 : -1;
+    s->out_len++;
+
+    s->pos++;
+    if (s->match > 0) {
+        s->match--;
+        idx_t link = s->states[s->state].link;
+        if (s->states[link].len >= s->match) {
+            s->state = link;
+        }
+    }
+}
+
+/**
+* @brief Process the symbol text[pos+match].
+*
+* If the match can be extended by it the match stays a previous factor
+* and the symbol joins the automaton. Otherwise the match is LPF[pos]
+* and the next position is tried with the same symbol, a position with
+* an empty match adds the symbol to the automaton.
+**/
+static void stream_symbol(lpf_stream *s, idx_t c) {
+    for (;;) {
+        idx_t next = edge_target(s, s->state, c);
+        if (next >= 0) {
+            s->state = next;
+            s->match++;
+            sam_extend(s, c);
+            return;
+        }
+        idx_t matched = s->match;
+        emit(s);
+        if (matched == 0) {
+            sam_extend(s, c);
+            return;
+        }
+    }
+}
+
+/**
+* @brief Create an empty stream of symbols of the given width.
+*
+* Every symbol value is a letter of its own, the alphabet needs no
+* bound (the edges are hashed), so 32-bit symbols need no compaction.
+*
+* @return Returns the stream, release it with lpf_stream_free.
+**/
+lpf_stream *lpf_stream_create(SymbolType type) {
+    lpf_stream *s = mem_calloc(1, sizeof(lpf_stream));
+    s->type = type;
+    s->slot_bits = 4;
+    s->slots = mem_alloc(((size_t)1 << s->slot_bits) * sizeof(idx_t));
+    memset(s->slots, 0xff, ((size_t)1 << s->slot_bits) * sizeof(idx_t));
+    new_state(s, 0, -1);
+    return s;
+}
+
+void lpf_stream_free(lpf_stream *s) {
+    if (s == NULL) {
+        return;
+    }
+    mem_free(s->states, (size_t)s->state_cap * sizeof(sam_state));
+    mem_free(s->edges, (size_t)s->edge_cap * sizeof(sam_edge));
+    mem_free(s->slots, ((size_t)1 << s->slot_bits) * sizeof(idx_t));
+    if (s->old_slots != NULL) {
+        mem_free(s->old_slots, ((size_t)1 << s->old_bits) * sizeof(idx_t));
+    }
+    mem_free(s->out_lpf, (size_t)s->out_cap * sizeof(idx_t));
+    mem_free(s->out_prev, (size_t)s->out_cap * sizeof(idx_t));
+    mem_free(s, sizeof(lpf_stream));
+}
+
+/**
+* @brief Append symbols to the text.
+*
+* The automaton grows by the appended symbols (at most two states and
+* amortized three edges per symbol), nothing is recomputed. The values
+* which became final are read with lpf_stream_read.
+*
+* @param[in,out] s The stream.
+* @param[in] symbols The new symbols, in the width of the stream.
+* @param[in] len Their number.
+**/
+void lpf_stream_append(lpf_stream *s, const void *symbols, idx_t len) {
+    if (s->finished) {
+        fprintf(stderr, "Append to a finished LPF stream\n");
+        abort();
+    }
+    // Two states per symbol have to fit the index type
+    if (len > IDX_MAX / 2 - s->received) {
+        fprintf(stderr, "Stream too long for %d-bit indices (build lpf64)\n", INDEX_BITS);
+        exit(1);
+    }
+    for (idx_t i = 0; i < len; i++) {
+        stream_symbol(s, (idx_t)raw_symbol(symbols, s->type, i));
+    }
+    s->received += len;
+}
+
+/**
+* @brief End of the text, the remaining positions become final.
+*
+* The match at pos reaches the end, so LPF[pos+k] = match - k.
+**/
+void lpf_stream_finish(lpf_stream *s) {
+    while (s->pos < s->received) {
+        emit(s);
+    }
+    s->finished = 1;
+}
+
+/**
+* @brief Take the next final values, in the order of their positions.
+*
+* @param[in,out] s The stream.
+* @param[out] lpf Receives up to max LPF values.
+* @param[out] prev_occ Receives their PrevOcc (the first previous occurrence,
+*   -1 if the LPF is 0), NULL to drop them.
+* @param[in] max The size of the buffers.
+*
+* @return Returns the number of values written.
+**/
+idx_t lpf_stream_read(lpf_stream *s, idx_t *lpf, idx_t *prev_occ, idx_t max) {
+    idx_t n = s->out_len - s->out_start;
+    n = n < max ? n : max;
+
+    memcpy(lpf, s->out_lpf + s->out_start, (size_t)n * sizeof(idx_t));
+    if (prev_occ != NULL) {
+        memcpy(prev_occ, s->out_prev + s->out_start, (size_t)n * sizeof(idx_t));
+    }
+    s->out_start += n;
+
+    // Unread values move to the front once the read ones take half of the buffer
+    if (s->out_start == s->out_len) {
+        s->out_start = s->out_len = 0;
+    } else if (s->out_start > s->out_cap / 2) {
+        idx_t left = s->out_len - s->out_start;
+        memmove(s->out_lpf, s->out_lpf + s->out_start, (size_t)left * sizeof(idx_t));
+        memmove(s->out_prev, s->out_prev + s->out_start, (size_t)left * sizeof(idx_t));
+        s->out_start = 0;
+        s->out_len = left;
+    }
+    return n;
+}
+
+// Symbols appended so far
+idx_t lpf_stream_length(const lpf_stream *s) {
+    return s->received;
+}
+
+// Positions whose LPF is final (read or not)
+idx_t lpf_stream_final(const lpf_stream *s) {
+    return s->pos;
+}
+
+/**
+* @brief Bytes held by the stream, the automaton and the unread values.
+**/
+size_t lpf_stream_memory(const lpf_stream *s) {
+    return sizeof(lpf_stream) + (size_t)s->state_cap * sizeof(sam_state) + (size_t)s->edge_cap * sizeof(sam_edge)
+        + ((size_t)1 << s->slot_bits) * sizeof(idx_t) + (s->old_slots != NULL ? ((size_t)1 << s->old_bits) * sizeof(idx_t) : 0)
+        + 2 * (size_t)s->out_cap * sizeof(idx_t);
+}
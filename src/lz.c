@@ -0,0 +1,340 @@
+#include "lz.h"
+#include "lpf.h"
+#include "phase.h"
+#include "text.h"
+#include "constants.h"
+#include "workspace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/*
+* Factor stream:
+*   "LPZ2", symbol width in bytes, varint text length
+*   per token: varint (count << 1 | kind), then
+*     kind = 0: a run of count literal symbols (raw bytes for 8-bit text, varints otherwise)
+*     kind = 1: a copy of count symbols, varint distance to the source (i - PrevOcc[i])
+* A previous factor which costs at least as many bytes as its symbols as
+* literals is written as literals, consecutive literals share one token.
+* Incompressible input grows by a few bytes per run instead of doubling.
+*/
+
+struct lz_writer {
+    FILE *out;
+    uint8_t buffer[LZ_BUFFER_SIZE];
+    size_t used;
+    size_t total;
+};
+typedef struct lz_writer lz_writer;
+
+struct lz_reader {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+};
+typedef struct lz_reader lz_reader;
+
+static void flush_writer(lz_writer *w) {
+    if (w->out != NULL && w->used > 0 && fwrite(w->buffer, 1, w->used, w->out) != w->used) {
+        perror("Error writing factors");
+        exit(1);
+    }
+    w->total += w->used;
+    w->used = 0;
+}
+
+static inline void put_byte(lz_writer *w, uint8_t byte) {
+    if (w->used == LZ_BUFFER_SIZE) {
+        flush_writer(w);
+    }
+    w->buffer[w->used++] = byte;
+}
+
+static inline void put_varint(lz_writer *w, uint64_t val) {
+    while (val >= 0x80) {
+        put_byte(w, (uint8_t)(val | 0x80));
+        val >>= 7;
+    }
+    put_byte(w, (uint8_t)val);
+}
+
+static inline int varint_size(uint64_t val) {
+    int size = 1;
+    while (val >= 0x80) {
+        val >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static inline uint64_t literal_symbol(const text *t, const alphabet_map *map, idx_t i) {
+    return map != NULL ? alphabet_letter(map, text_symbol(t, i)) : (uint64_t)text_symbol(t, i);
+}
+
+// Writes the literals t[from...to) as one run
+static void put_literals(lz_writer *w, const text *t, const alphabet_map *map, int bytes, idx_t from, idx_t to) {
+    if (from == to) {
+        return;
+    }
+    put_varint(w, (uint64_t)(to - from) << 1);
+    for (idx_t i = from; i < to; i++) {
+        if (bytes) {
+            put_byte(w, (uint8_t)literal_symbol(t, map, i));
+        } else {
+            put_varint(w, literal_symbol(t, map, i));
+        }
+    }
+}
+
+static void corrupt_stream(const char *reason) {
+    fprintf(stderr, "Corrupt factor stream: %s\n", reason);
+    exit(1);
+}
+
+static inline uint8_t get_byte(lz_reader *r) {
+    if (r->pos == r->size) {
+        corrupt_stream("unexpected end");
+    }
+    return r->data[r->pos++];
+}
+
+static inline uint64_t get_varint(lz_reader *r) {
+    uint64_t val = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = get_byte(r);
+        val |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return val;
+        }
+    }
+    corrupt_stream("varint too long");
+    return 0;
+}
+
+/**
+* @brief Write the self-referential LZ factorization of t.
+*
+* The factorization is read off the LPF table in one pass: a factor
+* starting at i is the longest previous factor (LPF[i] symbols copied
+* from PrevOcc[i], the source may overlap the factor) if its token is
+* shorter than the same symbols as literals, a literal otherwise. The
+* next factor starts right after it. The literals and the symbol width
+* of a compacted text are those of the original.
+*
+* @param[in] t The text.
+* @param[in] map The original symbols if t was compacted, NULL otherwise.
+* @param[in] lpf The LPF array of t.
+* @param[in] prev_occ The previous occurrences (see lpf_array_prev_ws).
+* @param[in] out Output file (NULL to only count the bytes).
+*
+* @return Returns the number of factors (copies and literals) and the sizes.
+**/
+lz_stats lz_encode(const text *t, const alphabet_map *map, const idx_t *lpf, const idx_t *prev_occ, FILE *out) {
+    lz_writer *w = malloc(sizeof(lz_writer));
+    SymbolType type = map != NULL ? map->type : t->type;
+    lz_stats stats = {0, 0, (size_t)t->len * symbol_size(type), 0};
+    int bytes = type == SYM_U8;
+    idx_t run = 0; // The pending literals are t[run...i)
+
+    if (w == NULL) {
+        perror("Error allocating the factor writer");
+        exit(1);
+    }
+    w->out = out;
+    w->used = 0;
+    w->total = 0;
+
+    for (int i = 0; i < LZ_MAGIC_LEN; i++) {
+        put_byte(w, LZ_MAGIC[i]);
+    }
+    put_byte(w, (uint8_t)symbol_size(type));
+    put_varint(w, t->len);
+
+    for (idx_t i = 0; i < t->len; stats.factors++) {
+        idx_t len = lpf[i];
+        if (len > 0) {
+            int copy = varint_size((uint64_t)len << 1 | 1) + varint_size(i - prev_occ[i]);
+            int literal = 0;
+            for (idx_t k = 0; k < len && literal < copy; k++) {
+                literal += bytes ? 1 : varint_size(literal_symbol(t, map, i + k));
+            }
+            if (literal >= copy) {
+                put_literals(w, t, map, bytes, run, i);
+                put_varint(w, (uint64_t)len << 1 | 1);
+                put_varint(w, i - prev_occ[i]);
+                i += len;
+                run = i;
+                continue;
+            }
+        }
+        stats.literals++;
+        i++;
+    }
+    put_literals(w, t, map, bytes, run, t->len);
+
+    flush_writer(w);
+    stats.out_bytes = w->total;
+    free(w);
+    return stats;
+}
+
+/**
+* @brief Compute LPF and PrevOcc of t and write its factorization.
+*
+* @param[in] t The text.
+* @param[in] map The original symbols if t was compacted, NULL otherwise.
+* @param[in] out Output file (NULL to only count the bytes).
+*
+* @return Returns the number of factors and the sizes.
+**/
+lz_stats lz_compress(const text *t, const alphabet_map *map, FILE *out) {
+    idx_t n = t->len > 0 ? t->len : 1;
+    workspace *ws = create_workspace(lpf_workspace_size(t));
+    idx_t *lpf = mem_alloc(n * sizeof(idx_t));
+    idx_t *prev_occ = mem_alloc(n * sizeof(idx_t));
+
+    lpf_array_prev_ws(ws, t, lpf, prev_occ);
+    cleanup_workspace(ws);
+
+    phase_begin(PHASE_ENCODE);
+    lz_stats stats = lz_encode(t, map, lpf, prev_occ, out);
+    phase_end(PHASE_ENCODE);
+    mem_free(lpf, n * sizeof(idx_t));
+    mem_free(prev_occ, n * sizeof(idx_t));
+    return stats;
+}
+
+void print_lz_stats(lz_stats *stats, double seconds) {
+    printf("Factors: %lld (%lld literals), %zu -> %zu bytes, ratio %.3f\n", (long long)stats->factors, (long long)stats->literals, stats->in_bytes, stats->out_bytes, stats->out_bytes > 0 ? (double)stats->in_bytes / stats->out_bytes : 0.0);
+    printf("Time: %f seconds, %.0f factors/s, %.2f MB/s\n", seconds, seconds > 0 ? stats->factors / seconds : 0.0, seconds > 0 ? stats->in_bytes / seconds / 1e6 : 0.0);
+}
+
+// Room for need symbols of the decoded text, doubling up to its length n
+static uint8_t *grow_output(uint8_t *out, idx_t *cap, idx_t need, idx_t n, size_t width) {
+    if (out != NULL && need <= *cap) {
+        return out;
+    }
+    if (out != NULL) {
+        idx_t doubled = *cap <= n / 2 ? 2 * *cap : n;
+        *cap = need > doubled ? need : doubled;
+    }
+    out = realloc(out, (*cap > 0 ? *cap : 1) * width);
+    if (out == NULL) {
+        perror("Error allocating the decoded text");
+        exit(1);
+    }
+    return out;
+}
+
+/**
+* @brief Rebuild the text from a factor stream.
+*
+* Factors are copied front to back in chunks of at most the
+* distance, so overlapping sources repeat the period correctly. The
+* text grows with the decoded tokens, a length in the header which
+* the stream does not reach allocates no more than the stream holds.
+*
+* @param[in] data The factor stream.
+* @param[in] size Size of the stream in bytes.
+*
+* @return Returns the text, its symbols are allocated with malloc. Its
+*   alphabet is 0 if a 32-bit symbol does not fit the index type (the
+*   32-bit build), compact_alphabet gives such a text a bound.
+**/
+text lz_decode(const uint8_t *data, size_t size) {
+    lz_reader r = {data, size, 0};
+    SymbolType type;
+
+    for (int i = 0; i < LZ_MAGIC_LEN; i++) {
+        if (get_byte(&r) != (uint8_t)LZ_MAGIC[i]) {
+            corrupt_stream("bad magic");
+        }
+    }
+    switch (get_byte(&r)) {
+        case 1:
+            type = SYM_U8;
+            break;
+        case 2:
+            type = SYM_U16;
+            break;
+        case 4:
+            type = SYM_U32;
+            break;
+        case 8:
+            if (sizeof(idx_t) != 8) {
+                corrupt_stream("64-bit symbols need the lpf64 build");
+            }
+            type = SYM_IDX;
+            break;
+        default:
+            corrupt_stream("unsupported symbol width");
+            return text_init(NULL, 0, SYM_U8, 1);
+    }
+
+    uint64_t len = get_varint(&r);
+    if (len >= (uint64_t)IDX_MAX) {
+        corrupt_stream("text too long for the index type");
+    }
+
+    idx_t n = (idx_t)len;
+    uint64_t max_sym = 0;
+    size_t width = symbol_size(type);
+    // The header length is not trusted: every literal takes a byte of the
+    // stream, so start at what the rest of it holds and grow with the tokens
+    idx_t cap = (uint64_t)n < r.size - r.pos ? n : (idx_t)(r.size - r.pos);
+    uint8_t *out = grow_output(NULL, &cap, cap, n, width);
+
+    for (idx_t i = 0; i < n;) {
+        uint64_t token = get_varint(&r);
+        uint64_t count = token >> 1;
+        if (count == 0 || count > (uint64_t)(n - i)) {
+            corrupt_stream("factor out of range");
+        }
+        if (!(token & 1) && count > r.size - r.pos) {
+            corrupt_stream("unexpected end");
+        }
+        out = grow_output(out, &cap, i + (idx_t)count, n, width);
+        if (!(token & 1)) {
+            for (idx_t end = i + (idx_t)count; i < end; i++) {
+                uint64_t sym = type == SYM_U8 ? get_byte(&r) : get_varint(&r);
+                if (width < 8 ? sym >> (8 * width) != 0 : sym >= (uint64_t)IDX_MAX - 1) {
+                    corrupt_stream("literal out of range");
+                }
+                switch (type) {
+                    case SYM_U8:
+                        out[i] = (uint8_t)sym;
+                        break;
+                    case SYM_U16:
+                        ((uint16_t *)out)[i] = (uint16_t)sym;
+                        break;
+                    case SYM_U32:
+                        ((uint32_t *)out)[i] = (uint32_t)sym;
+                        break;
+                    case SYM_IDX:
+                    default:
+                        ((idx_t *)out)[i] = (idx_t)sym;
+                        break;
+                }
+                max_sym = sym > max_sym ? sym : max_sym;
+            }
+            continue;
+        }
+
+        uint64_t dist = get_varint(&r);
+        if (dist == 0 || dist > (uint64_t)i) {
+            corrupt_stream("factor out of range");
+        }
+        for (idx_t left = (idx_t)count; left > 0;) {
+            idx_t chunk = left < (idx_t)dist ? left : (idx_t)dist;
+            memcpy(out + i * width, out + (i - (idx_t)dist) * width, chunk * width);
+            i += chunk;
+            left -= chunk;
+        }
+    }
+    if (max_sym + 1 >= (uint64_t)IDX_MAX) {
+        text t = {out, n, 0, type};
+        return t;
+    }
+    return text_init(out, n, type, (idx_t)max_sym + 1);
+}
@@ -0,0 +1,28 @@
+#include "constants.h"
+#include "text.h"
+#include "liblpf.h"
+
+#include <stdio.h>
+#include <stddef.h>
+
+#ifndef LZ_H
+#define LZ_H
+
+#define LZ_MAGIC "LPZ2"
+#define LZ_MAGIC_LEN 4
+#define LZ_BUFFER_SIZE (1 << 16)
+
+struct lz_stats {
+    idx_t factors;
+    idx_t literals;
+    size_t in_bytes;
+    size_t out_bytes;
+};
+typedef struct lz_stats lz_stats;
+
+lz_stats lz_encode(const text *t, const alphabet_map *map, const idx_t *lpf, const idx_t *prev_occ, FILE *out);
+lz_stats lz_compress(const text *t, const alphabet_map *map, FILE *out);
+text lz_decode(const uint8_t *data, size_t size);
+void print_lz_stats(lz_stats *stats, double seconds);
+
+#endif
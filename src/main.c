@@ -1,9 +1,20 @@
 #include "lpf.h"
+#include "liblpf.h"
+#include "lz.h"
 #include "lcp.h"
+#include "text.h"
 #include "util.h"
+#include "input.h"
+#include "mismatch.h"
 #include "tuple.h"
+#include "radix.h"
 #include "constants.h"
+#include "parallel.h"
 #include "benchmark.h"
+#include "corpus.h"
+#include "batch.h"
+#include "phase.h"
+#include "workspace.h"
 #include "suffix_array.h"
 #include "suffix_array_qsort.h"
 
@@ -13,6 +24,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
+#include <fcntl.h>
 
 void print_help() {
     printf("Usage: ./lpf [options]\n");
@@ -20,119 +32,309 @@ void print_help() {
     printf("  -h, --help                                        Display this help message\n");
     printf("  -l, --lpf                                         Calculate the lpf array\n");
     printf("  -s, --suffix                                      Calculate the suffix and lcp arrays\n");
-    printf("  -v, --validate [sl][rf] <length> <tries> <asize>  Validate the [sl] agains the naive method <tries> random strings of length <length>\n");
-    printf("  -b, --benchmark [sl][rf] <length> <tries> <asize> Perform a benchmark with a random string[1...<length>], <tries> times\n");
+    printf("  -v, --validate [slo][text] <length> <tries> <asize>  Validate the [sl] agains the naive method on <tries> texts of length <length>\n");
+    printf("  -b, --benchmark [slzo][text] <length> <tries> <asize> Perform a benchmark with a text[1...<length>], <tries> times\n");
+    printf("      o is the streaming LPF, its ingest rate against lpf_array\n");
+    printf("      [text] is r (random), f (Fibonacci), t (Thue-Morse), p (period-doubling), u (run-rich), m (Markov), d (DNA) or c (--corpus windows)\n");
+    printf("  -K, --order <k>                                   Order of the Markov texts, default 3 (must precede the mode)\n");
+    printf("  -E, --entropy <bits>                              Entropy per letter of the Markov texts, default 1 (must precede the mode)\n");
+    printf("  -R, --repeats <fraction>                          Fraction of the DNA texts copied from earlier with mutations, default 0.5 (must precede the mode)\n");
+    printf("  -C, --corpus <path>                               File the c texts are random windows of, --width applies (must precede the mode)\n");
+    printf("  -u, --warmup <n>                                  Untimed runs before the <tries> timed runs of every -b data point, default 1 (must precede the mode)\n");
+    printf("  -p, --points <n>                                  Benchmark <n> lengths, each --growth times the previous (Fibonacci: the next word), default 1 (must precede the mode)\n");
+    printf("  -g, --growth <factor>                             Length factor between the --points, default 2 (must precede the mode)\n");
+    printf("  -S, --seed <n>                                    Seed of the random texts, run i of -b uses <n> + i, default 1 (-b) or the time (-v)\n");
+    printf("  -P, --perf                                        Read the hardware counters of every -b run and phase into the CSV (Linux perf_event_open) (must precede the mode)\n");
+    printf("  -T, --trace <file>                                Write the phases of every suffix array and LPF call as Chrome trace events (JSON) to <file> (must precede the mode)\n");
+    printf("  -n, --no-naive                                    Skip the naive (or binode) baseline of -b, NALG is -1 (must precede the mode)\n");
+    printf("  -t, --threads <n>                                 Use <n> threads for the suffix array, PLCP and stack LPF construction (must precede the mode)\n");
+    printf("  -e, --engine <dc3|sais>                           Suffix array engine used by -l, -s, -v and -b (must precede the mode)\n");
+    printf("  -f, --file <path>                                 Read the input of -l, -s, -z and -o from a file instead of stdin, and the records of -B (must precede the mode)\n");
+    printf("  -w, --width <8|16|32>                             Bits per symbol of the --file input, default 8 (must precede the mode)\n");
+    printf("  -x, --small <n>                                   Sort inputs of up to <n> letters by comparing their suffixes instead of the engine, default %d, 0 for -v and -b (must precede the mode)\n", SA_SMALL_LEN);
+    printf("  -X, --cutoff <n>                                  Sort DC3 reduced problems of up to <n> names by comparing their suffixes, default %d (must precede the mode)\n", DC3_CUTOFF);
+    printf("  -r, --radix <packed|tuples>                       DC3 radix sort of packed 64-bit keys (default) or of the tuples (must precede the mode)\n");
+    printf("  -m, --merge <packed|tuples>                       DC3 merge comparing packed 64-bit keys (default) or tuples (must precede the mode)\n");
+    printf("  -a, --lpf-alg <binode|lean|stack>                 LPF algorithm used by -l, -z, -v and -b, lean bounds the memory (must precede the mode)\n");
+    printf("  -k, --simd <auto|scalar|sse2|avx2>                Kernel for the symbol comparisons of LCP and the naive checks, default auto\n");
+    printf("  -c, --compact-lcp                                 Keep the LCP of -s as a 2n-bit PLCP and decode it on demand (must precede the mode)\n");
+    printf("  -z, --lz <output>                                 Write the LZ factorization of the input (--file or stdin) to <output>\n");
+    printf("  -d, --unlz <input> <output>                       Decode an LZ factor stream <input> into <output>\n");
+    printf("  -B, --batch [sl] <output>                         Write the suffix or LPF array of every record of --file to <output>, one line each, on --threads workers\n");
+    printf("  -o, --stream <output>                             Write \"LPF PrevOcc\" of every position of the input (--file or stdin) to <output> as soon as it is final\n");
+    printf("  -j, --chunk <n>                                   Symbols appended to the stream at once by -o and -b o, default %d (must precede the mode)\n", STREAM_CHUNK);
+    printf("  -F, --records <lines|prefixed>                    Batch records are lines (default) or have a 32-bit little-endian length before them (must precede the mode)\n");
     printf("Example:\n");
     printf("  ./PATH/TO/PROGRAM/lpf -b sr 1000000 10 3\n");
     printf("  ./PATH/TO/PROGRAM/lpf -s\n");
     printf("In case of fibonacci numbers ('f' argument) <length> means the #fibonnaci word\n");
     printf("  ./PATH/TO/PROGRAM/lpf -v lf 10 1 2  Validate LPF arrays on the 10th fibonacci word (asize is by definition 2)\n");
     printf("  ./PATH/TO/PROGRAM/lpf -b sr 10000 10 4  Benchmark suffix arrays on random words of length 10000, 10 times with alphabet size 4.\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -t 8 -b lr 10000000 3 4  Benchmark LPF arrays using 8 threads\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -e sais -v sr 10000 10 4  Validate the SA-IS suffix arrays\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -a lean -f data.bin -z data.lz  Compress a large file in about 3 words per symbol\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -a stack -b lr 10000000 3 4  Benchmark the stack LPF against the binode pass\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -t 8 -a stack -f data.bin -z data.lz  Compress with the parallel LPF\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -f data.bin -l  LPF array of a (binary) file\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -f data.bin -z data.lz  Compress a file, ./lpf -d data.lz data.out restores it\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -t 8 -f reads.txt -B l reads.lpf  LPF arrays of every line of reads.txt on 8 threads\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -b zr 1000000 3 4  Benchmark the LZ factorization (factors/s, ratio)\n");
+    printf("  tail -f app.log | ./PATH/TO/PROGRAM/lpf -j 4096 -o app.lpf  LPF of a growing log, written as it arrives\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -b or 10000000 3 4  Benchmark the streaming ingest rate\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -E 0.5 -K 4 -b lm 1000000 3 16  Benchmark LPF arrays on Markov texts of 0.5 bits per letter\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -C corpus.txt -v lc 5000 20 0  Validate LPF arrays on 20 windows of a file\n");
+    printf("  ./PATH/TO/PROGRAM/lpf -n -u 2 -p 6 -b sr 100000 11 4  Sweep the suffix arrays over 100000...3200000, 11 runs each, CSV in results/\n");
 }
 
-void suffix_array_from_input() { 
-    char *input = NULL;
-    size_t input_length = 0;
-    ssize_t nread;
-    int str_len;
-    printf("Enter a string: ");
-    if ((nread = getdelim(&input, &input_length, '\n', stdin)) != -1) {
-        // Remove delimiter
-        input[strcspn(input, "\n")] = '\0';
-        str_len = nread-1;
-        printf("Retrieved line of length %d\n", str_len);
-        LOG_FUNC(fwrite, input, nread, 1, stdout);
-    } else {
-        exit(1);
-    }  
-    printf("\n");
-
-    // Expand character string to int type this puts a limit
-    int *str = malloc(sizeof(int)*(str_len+ADDITIONAL_PADDING));
+// Set with --file, otherwise -l and -s read a line from stdin
+static const char *input_path = NULL;
+static SymbolType input_type = SYM_U8;
+// Set with --compact-lcp
+static int compact_lcp = 0;
+// Set with --corpus, opened with the --width of the command line
+static const char *corpus_path = NULL;
+// Set with --records
+static RecordFormat record_format = RECORDS_LINES;
+// Set with --chunk
+static idx_t stream_chunk = STREAM_CHUNK;
+// Set with --small, otherwise -v and -b check and time the engine itself
+static int small_len_set = 0;
 
-    for (int i = 0; i < str_len; i++) {
-        str[i] = (int)input[i];
+text open_input(input_file *in) {
+    if (input_path != NULL) {
+        return map_input_file(in, input_path, input_type);
     }
-    for (int i = str_len; i < str_len+ADDITIONAL_PADDING; i++) {
-        str[i] = 0;
-    }
-    free(input);
+    return read_input_line(in);
+}
+
+void suffix_array_from_input() { 
+    input_file in;
+    text str = open_input(&in);
+    idx_t str_len = str.len;
 
-    int *sa = suffix_array(str, str_len);
-    int *sar = reverse_array(sa,  str_len);
-    int *lcp = lcp_array(str, sa, sar, str_len);
+    idx_t *sa = suffix_array_engine(&str);
 
-    // int *saq = suffix_array_qsort(str, str_len);
+    // int *saq = suffix_array_qsort(&str);
     // printf_line(saq, str_len);
 
-    print_suffix_array(str, sa, str_len);
+    // Printing every suffix is quadratic, files only get the arrays
+    if (input_path == NULL) {
+        print_suffix_array(&str, sa);
+    }
 
     printf("SA:  ");
-    printf_array(sa, str_len);
+    print_index_array(sa, str_len);
 
     printf("LCP: ");
-    printf_array(lcp+1, str_len-1);
+    if (compact_lcp) {
+        succinct_plcp *plcp = succinct_plcp_create(&str, sa);
+        printf("[");
+        for (idx_t i = 1; i < str_len; i++) {
+            printf(i + 1 < str_len ? "%" PRIdx " " : "%" PRIdx, succinct_lcp_get(plcp, sa, i));
+        }
+        printf("]\n");
+        cleanup_succinct_plcp(plcp);
+    } else {
+        idx_t *plcp = plcp_array(&str, sa);
+        idx_t *lcp = lcp_from_plcp_into(plcp, sa, str_len, malloc((str_len > 0 ? str_len : 1) * sizeof(idx_t)));
+        print_index_array(lcp+1, str_len-1);
+        mem_free(plcp, str_len * sizeof(idx_t));
+        free(lcp);
+    }
     printf("\n");
-    free(sa);
-    free(sar);
-    free(str);
-    free(lcp);
+    mem_free(sa, str_len * sizeof(idx_t));
+    close_input(&in);
 }
 
 void lpf_array_from_input() {
-    char *input = NULL;
-    size_t input_length = 0;
-    ssize_t nread;
-    int str_len;
-    printf("Enter a string: ");
-    if ((nread = getdelim(&input, &input_length, '\n', stdin)) != -1) {
-        // Remove delimiter
-        input[strcspn(input, "\n")] = '\0';
-        str_len = nread-1;
-        printf("Retrieved line of length %d\n", str_len);
-        LOG_FUNC(fwrite, input, nread, 1, stdout);
-    } else {
+    input_file in;
+    text str = open_input(&in);
+
+    idx_t *prev_occ;
+    idx_t *lpf = lpf_array_prev(&str, &prev_occ);
+
+    printf("LPF = ");
+    print_index_array(lpf, str.len);
+    printf("PrevOcc = ");
+    print_index_array(prev_occ, str.len);
+
+    if (input_path == NULL) {
+        print_lpf_array(&str, lpf, prev_occ);
+    }
+
+    mem_free(lpf, str.len * sizeof(idx_t));
+    mem_free(prev_occ, str.len * sizeof(idx_t));
+    close_input(&in);
+}
+
+void lz_from_input(const char *path) {
+    input_file in;
+    text str = open_input(&in);
+    FILE *out = fopen(path, "wb");
+
+    if (out == NULL) {
+        perror("Error opening output file");
         exit(1);
-    }  
-    printf("\n");
+    }
 
-    // Expand character string to int type this puts a limit
-    int *str = malloc(sizeof(int)*(str_len+ADDITIONAL_PADDING));
+    clock_t start = clock();
+    lz_stats stats = lz_compress(&str, in.letters != NULL ? &in.map : NULL, out);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
 
-    for (int i = 0; i < str_len; i++) {
-        str[i] = (int)input[i];
+    if (fclose(out) != 0) {
+        perror("Error writing output file");
+        exit(1);
     }
-    for (int i = str_len; i < str_len+ADDITIONAL_PADDING; i++) {
-        str[i] = 0;
+    print_lz_stats(&stats, seconds);
+    close_input(&in);
+}
+
+/**
+* @brief Stream the input (--file or stdin until EOF) through lpf_stream.
+*
+* The input is read as it arrives in chunks of up to stream_chunk
+* symbols of the --width, a symbol split between two reads is carried
+* over. After every chunk the positions which became final are written
+* to output, one "LPF PrevOcc" line each, and the file is flushed.
+**/
+void stream_from_input(const char *path) {
+    int fd = input_path != NULL ? open(input_path, O_RDONLY) : STDIN_FILENO;
+    FILE *out = fopen(path, "w");
+
+    if (fd < 0 || out == NULL) {
+        perror(fd < 0 ? "Error opening file" : "Error opening output file");
+        exit(1);
     }
-    free(input);
 
-    int *lpf = lpf_array(str, str_len);
+    size_t width = symbol_size(input_type);
+    size_t buf_size = (size_t)stream_chunk * width;
+    uint8_t *buf = malloc(buf_size);
+    idx_t *lpf = malloc((size_t)stream_chunk * sizeof(idx_t));
+    idx_t *prev_occ = malloc((size_t)stream_chunk * sizeof(idx_t));
+    lpf_stream *s = lpf_stream_create(input_type);
+    size_t used = 0;
+    double start = wall_time();
 
-    printf("LPF = ");
-    printf_array(lpf, str_len);
+    for (;;) {
+        ssize_t got = read(fd, buf + used, buf_size - used);
+        if (got < 0) {
+            perror("Error reading input");
+            exit(1);
+        }
+        used += got;
+        idx_t symbols = (idx_t)(used / width);
+        if (got == 0 || symbols > 0) {
+            if (got == 0) {
+                lpf_stream_finish(s);
+            } else {
+                lpf_stream_append(s, buf, symbols);
+                memmove(buf, buf + symbols * width, used - symbols * width);
+                used -= symbols * width;
+            }
+            for (idx_t n; (n = lpf_stream_read(s, lpf, prev_occ, stream_chunk)) > 0;) {
+                for (idx_t i = 0; i < n; i++) {
+                    fprintf(out, "%" PRIdx " %" PRIdx "\n", lpf[i], prev_occ[i]);
+                }
+            }
+            fflush(out);
+        }
+        if (got == 0) {
+            break;
+        }
+    }
+    double seconds = wall_time() - start;
 
-    print_lpf_array(str, lpf, str_len);
+    if (fclose(out) != 0) {
+        perror("Error writing output file");
+        exit(1);
+    }
+    if (used > 0) {
+        fprintf(stderr, "Ignored %zu trailing bytes of a partial symbol\n", used);
+    }
+    idx_t len = lpf_stream_length(s);
+    printf("Streamed %" PRIdx " symbols (%s) in %f seconds, %.2f Msymbols/s, %.2f bytes per symbol\n", len, symbol_type_name(input_type), seconds, seconds > 0 ? len / seconds / 1e6 : 0.0, len > 0 ? (double)lpf_stream_memory(s) / len : 0.0);
 
-    free(str);
+    lpf_stream_free(s);
+    free(buf);
     free(lpf);
+    free(prev_occ);
+    if (input_path != NULL) {
+        close(fd);
+    }
+}
+
+void unlz_file(const char *in_path, const char *out_path) {
+    input_file in;
+    text stream = map_input_file(&in, in_path, SYM_U8);
+
+    clock_t start = clock();
+    text str = lz_decode(stream.symbols, in.size);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    FILE *out = fopen(out_path, "wb");
+    size_t bytes = (size_t)str.len * symbol_size(str.type);
+    if (out == NULL || fwrite(str.symbols, 1, bytes, out) != bytes || fclose(out) != 0) {
+        perror("Error writing output file");
+        exit(1);
+    }
+    printf("Decoded %zu bytes in %f seconds\n", bytes, seconds);
+
+    free((void *)str.symbols);
+    close_input(&in);
 }
 
- 
 int main(int argc, char *argv[]) {
-    int size, tries, asize, str_type_arg;
+    idx_t size;
+    int tries, asize, str_type_arg;
     char alg_type_arg;
     StrType str_type = RANDOM;
-    const char *short_opts = "hb:sv:l";
+    SAEngine engine = DC3;
+    RadixKind radix = RADIX_PACKED;
+    MergeKind merge = MERGE_PACKED;
+    LPFAlgorithm lpf_alg = LPF_BINODE;
+    MismatchKernel kernel = MISMATCH_AUTO;
+    const char *short_opts = "hb:sv:lt:u:p:g:S:nPT:K:E:R:C:e:r:m:a:k:f:w:cz:d:B:F:x:X:o:j:";
     const struct option long_opts[] = {
         {"help",    no_argument,       NULL, 'h'},
         {"lpf", no_argument, NULL, 'l'},
         {"suffix", no_argument, NULL, 's'},
         {"benchmark",  required_argument, NULL, 'b'},
         {"validate",  required_argument, NULL, 'v'},
+        {"threads",  required_argument, NULL, 't'},
+        {"warmup",  required_argument, NULL, 'u'},
+        {"points",  required_argument, NULL, 'p'},
+        {"growth",  required_argument, NULL, 'g'},
+        {"seed",  required_argument, NULL, 'S'},
+        {"no-naive",  no_argument, NULL, 'n'},
+        {"perf",  no_argument, NULL, 'P'},
+        {"trace",  required_argument, NULL, 'T'},
+        {"order",  required_argument, NULL, 'K'},
+        {"entropy",  required_argument, NULL, 'E'},
+        {"repeats",  required_argument, NULL, 'R'},
+        {"corpus",  required_argument, NULL, 'C'},
+        {"engine",  required_argument, NULL, 'e'},
+        {"radix",  required_argument, NULL, 'r'},
+        {"merge",  required_argument, NULL, 'm'},
+        {"lpf-alg",  required_argument, NULL, 'a'},
+        {"simd",  required_argument, NULL, 'k'},
+        {"file",  required_argument, NULL, 'f'},
+        {"width",  required_argument, NULL, 'w'},
+        {"compact-lcp",  no_argument, NULL, 'c'},
+        {"lz",  required_argument, NULL, 'z'},
+        {"unlz",  required_argument, NULL, 'd'},
+        {"batch",  required_argument, NULL, 'B'},
+        {"records",  required_argument, NULL, 'F'},
+        {"small",  required_argument, NULL, 'x'},
+        {"cutoff",  required_argument, NULL, 'X'},
+        {"stream",  required_argument, NULL, 'o'},
+        {"chunk",  required_argument, NULL, 'j'},
         {NULL, 0, NULL, 0} // End marker
     };
-    int opt;
+    int opt, points = 1;
+    double growth = 2;
+
+    // -v draws new texts on every call unless --seed fixes them
+    srand((unsigned int)time(NULL));
 
     while ((opt = getopt_long(argc, argv, short_opts, long_opts, NULL)) != -1) {
         switch (opt) {
@@ -145,22 +347,144 @@ int main(int argc, char *argv[]) {
             case 'l':
                 lpf_array_from_input();
                 return 0;
+            case 'z':
+                lz_from_input(optarg);
+                return 0;
+            case 'o':
+                stream_from_input(optarg);
+                return 0;
+            case 'j':
+                stream_chunk = atoi(optarg) > 0 ? atoi(optarg) : 1;
+                set_benchmark_chunk(stream_chunk);
+                break;
+            case 'd':
+                if (optind >= argc) {
+                    print_help();
+                    return 1;
+                }
+                unlz_file(optarg, argv[optind]);
+                return 0;
+            case 'B':
+                if (optind >= argc || input_path == NULL) {
+                    print_help();
+                    return 1;
+                }
+                batch_run(optarg[0] == 's' ? SUFFIX_ARRAY : LPF, input_path, record_format, argv[optind]);
+                return 0;
+            case 'F':
+                if (!parse_record_format(optarg, &record_format)) {
+                    printf("Unknown record format: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 't':
+                set_thread_count(atoi(optarg));
+                break;
+            case 'u':
+                set_benchmark_warmup(atoi(optarg));
+                break;
+            case 'p':
+                points = atoi(optarg);
+                set_benchmark_sweep(points, growth);
+                break;
+            case 'g':
+                growth = atof(optarg);
+                set_benchmark_sweep(points, growth);
+                break;
+            case 'S':
+                set_benchmark_seed((unsigned int)strtoul(optarg, NULL, 10));
+                srand((unsigned int)strtoul(optarg, NULL, 10));
+                break;
+            case 'n':
+                set_benchmark_naive(0);
+                break;
+            case 'P':
+                set_benchmark_counters(1);
+                break;
+            case 'T':
+                if (!phase_trace_open(optarg)) {
+                    return 1;
+                }
+                atexit(phase_trace_close);
+                break;
+            case 'K':
+                set_markov_order(atoi(optarg));
+                break;
+            case 'E':
+                set_markov_entropy(atof(optarg));
+                break;
+            case 'R':
+                set_dna_repeats(atof(optarg));
+                break;
+            case 'C':
+                corpus_path = optarg;
+                break;
+            case 'e':
+                if (!parse_sa_engine(optarg, &engine)) {
+                    printf("Unknown engine: %s\n", optarg);
+                    return 1;
+                }
+                set_sa_engine(engine);
+                break;
+            case 'x':
+                set_sa_small_len(atoi(optarg));
+                small_len_set = 1;
+                break;
+            case 'X':
+                set_dc3_cutoff(atoi(optarg));
+                break;
+            case 'r':
+                if (!parse_radix_kind(optarg, &radix)) {
+                    printf("Unknown radix sort: %s\n", optarg);
+                    return 1;
+                }
+                set_radix_kind(radix);
+                break;
+            case 'm':
+                if (!parse_merge_kind(optarg, &merge)) {
+                    printf("Unknown merge: %s\n", optarg);
+                    return 1;
+                }
+                set_merge_kind(merge);
+                break;
+            case 'a':
+                if (!parse_lpf_algorithm(optarg, &lpf_alg)) {
+                    printf("Unknown LPF algorithm: %s\n", optarg);
+                    return 1;
+                }
+                set_lpf_algorithm(lpf_alg);
+                break;
+            case 'k':
+                if (!parse_mismatch_kernel(optarg, &kernel) || !set_mismatch_kernel(kernel)) {
+                    printf("Unknown or unsupported kernel: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'f':
+                input_path = optarg;
+                break;
+            case 'c':
+                compact_lcp = 1;
+                break;
+            case 'w':
+                if (!parse_symbol_width(optarg, &input_type)) {
+                    printf("Unknown symbol width: %s\n", optarg);
+                    return 1;
+                }
+                break;
             case 'b':
                 alg_type_arg = argv[optind-1][0];
                 str_type_arg = argv[optind-1][1];
-                size = atoi(argv[optind]);
+                size = atoll(argv[optind]);
                 tries = atoi(argv[optind+1]);
                 asize = atoi(argv[optind+2]);
 
-                switch (str_type_arg) {
-                    case 'r':
-                        str_type = RANDOM;
-                        break;
-                    case 'f':
-                        str_type = FIBONACCI;
-                        break;
-                    default:
-                        str_type = RANDOM;
+                if (!parse_str_type(str_type_arg, &str_type)) {
+                    str_type = RANDOM;
+                }
+                set_corpus_file(corpus_path, input_type);
+                if (!small_len_set) {
+                    set_sa_small_len(0);
                 }
 
                 switch (alg_type_arg) {
@@ -170,19 +494,35 @@ int main(int argc, char *argv[]) {
                     case 'l':
                         benchmark_runner(LPF, str_type, size, tries, asize);
                         return 0;
+                    case 'z':
+                        benchmark_runner(LZ, str_type, size, tries, asize);
+                        return 0;
+                    case 'o':
+                        benchmark_runner(STREAM, str_type, size, tries, asize);
+                        return 0;
                     default:
                         benchmark_runner(LPF, str_type, size, tries, asize);
                 }
                 return 0;
             case 'v':
                 alg_type_arg = argv[optind-1][0]; 
-                size = atoi(argv[optind]);
+                str_type_arg = argv[optind-1][0] != '\0' ? argv[optind-1][1] : 'r';
+                size = atoll(argv[optind]);
                 tries = atoi(argv[optind+1]);
                 asize = atoi(argv[optind+2]);
+                if (!parse_str_type(str_type_arg, &str_type)) {
+                    str_type = RANDOM;
+                }
+                set_corpus_file(corpus_path, input_type);
+                if (!small_len_set) {
+                    set_sa_small_len(0);
+                }
                 if (alg_type_arg == 's') {
-                    validate_suffix_array(size, tries, asize);
+                    validate_suffix_array(str_type, size, tries, asize);
+                } else if (alg_type_arg == 'o') {
+                    validate_stream(str_type, size, tries, asize);
                 } else {
-                    validate_lpf(size, tries, asize);
+                    validate_lpf(str_type, size, tries, asize);
                 }
                 return 0;
             case '?':
@@ -0,0 +1,176 @@
+#include "mismatch.h"
+#include "constants.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MISMATCH_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+* @brief First differing byte, 8 bytes per step.
+*
+* @return Returns the index of the first byte where a and b differ (bytes if none).
+**/
+static size_t mismatch_scalar(const void *a, const void *b, size_t bytes) {
+    const unsigned char *x = a, *y = b;
+    size_t i = 0;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t u, v;
+        memcpy(&u, x + i, 8);
+        memcpy(&v, y + i, 8);
+        if (u != v) {
+            return i + __builtin_ctzll(u ^ v) / 8;
+        }
+    }
+#endif
+    while (i < bytes && x[i] == y[i]) {
+        i++;
+    }
+    return i;
+}
+
+#ifdef MISMATCH_X86
+// 16 bytes per step, SSE2 is part of every x86-64 CPU
+__attribute__((target("sse2")))
+static size_t mismatch_sse2(const void *a, const void *b, size_t bytes) {
+    const unsigned char *x = a, *y = b;
+    size_t i = 0;
+
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i u = _mm_loadu_si128((const __m128i *)(x + i));
+        __m128i v = _mm_loadu_si128((const __m128i *)(y + i));
+        unsigned diff = ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(u, v)) & 0xFFFF;
+        if (diff) {
+            return i + __builtin_ctz(diff);
+        }
+    }
+    return i + mismatch_scalar(x + i, y + i, bytes - i);
+}
+
+// 64 bytes per step in two 32-byte halves
+__attribute__((target("avx2")))
+static size_t mismatch_avx2(const void *a, const void *b, size_t bytes) {
+    const unsigned char *x = a, *y = b;
+    size_t i = 0;
+
+    for (; i + 64 <= bytes; i += 64) {
+        __m256i eq0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(x + i)), _mm256_loadu_si256((const __m256i *)(y + i)));
+        __m256i eq1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(x + i + 32)), _mm256_loadu_si256((const __m256i *)(y + i + 32)));
+        if ((unsigned)_mm256_movemask_epi8(_mm256_and_si256(eq0, eq1)) != 0xFFFFFFFFu) {
+            unsigned diff = ~(unsigned)_mm256_movemask_epi8(eq0);
+            if (diff) {
+                return i + __builtin_ctz(diff);
+            }
+            return i + 32 + __builtin_ctz(~(unsigned)_mm256_movemask_epi8(eq1));
+        }
+    }
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(x + i)), _mm256_loadu_si256((const __m256i *)(y + i)));
+        unsigned diff = ~(unsigned)_mm256_movemask_epi8(eq);
+        if (diff) {
+            return i + __builtin_ctz(diff);
+        }
+    }
+    return i + mismatch_scalar(x + i, y + i, bytes - i);
+}
+#endif
+
+static MismatchKernel active_kernel = MISMATCH_SCALAR;
+static size_t (*mismatch_impl)(const void *, const void *, size_t) = mismatch_scalar;
+
+// Pick the widest kernel the CPU supports before main runs
+__attribute__((constructor))
+static void mismatch_init() {
+    set_mismatch_kernel(MISMATCH_AUTO);
+}
+
+/**
+* @brief Find the first byte where a[0...bytes-1] and b[0...bytes-1] differ.
+*
+* Runs the kernel chosen by set_mismatch_kernel, by default the widest
+* one the CPU supports (AVX2, SSE2 or the scalar loop).
+*
+* @return Returns the index of the first differing byte (bytes if none).
+**/
+size_t mismatch(const void *a, const void *b, size_t bytes) {
+    return mismatch_impl(a, b, bytes);
+}
+
+/**
+* @brief Select the mismatch kernel, MISMATCH_AUTO picks the best supported one.
+*
+* @return Returns 1 if the kernel is supported by the CPU, 0 otherwise (nothing changes).
+**/
+int set_mismatch_kernel(MismatchKernel kernel) {
+#ifdef MISMATCH_X86
+    __builtin_cpu_init();
+    int avx2 = __builtin_cpu_supports("avx2");
+    int sse2 = __builtin_cpu_supports("sse2");
+#else
+    int avx2 = 0, sse2 = 0;
+#endif
+
+    if (kernel == MISMATCH_AUTO) {
+        kernel = avx2 ? MISMATCH_AVX2 : (sse2 ? MISMATCH_SSE2 : MISMATCH_SCALAR);
+    }
+    switch (kernel) {
+#ifdef MISMATCH_X86
+        case MISMATCH_AVX2:
+            if (!avx2) {
+                return 0;
+            }
+            mismatch_impl = mismatch_avx2;
+            break;
+        case MISMATCH_SSE2:
+            if (!sse2) {
+                return 0;
+            }
+            mismatch_impl = mismatch_sse2;
+            break;
+#endif
+        case MISMATCH_SCALAR:
+            mismatch_impl = mismatch_scalar;
+            break;
+        default:
+            return 0;
+    }
+    active_kernel = kernel;
+    return 1;
+}
+
+MismatchKernel get_mismatch_kernel() {
+    return active_kernel;
+}
+
+const char *mismatch_kernel_name(MismatchKernel kernel) {
+    switch (kernel) {
+        case MISMATCH_AVX2:
+            return "avx2";
+        case MISMATCH_SSE2:
+            return "sse2";
+        case MISMATCH_SCALAR:
+            return "scalar";
+        case MISMATCH_AUTO:
+        default:
+            return "auto";
+    }
+}
+
+/**
+* @brief Parse the kernel name ("auto", "scalar", "sse2" or "avx2").
+*
+* @return Returns 1 if the name was recognized, 0 otherwise.
+**/
+int parse_mismatch_kernel(const char *name, MismatchKernel *kernel) {
+    for (int k = MISMATCH_AUTO; k <= MISMATCH_AVX2; k++) {
+        if (!strcmp(name, mismatch_kernel_name((MismatchKernel)k))) {
+            *kernel = (MismatchKernel)k;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "constants.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef MISMATCH_H
+#define MISMATCH_H
+
+// Matches up to this many bytes are found inline, longer ones by the vector kernel
+#define MISMATCH_INLINE_BYTES 32
+
+size_t mismatch(const void *a, const void *b, size_t bytes);
+int set_mismatch_kernel(MismatchKernel kernel);
+MismatchKernel get_mismatch_kernel();
+const char *mismatch_kernel_name(MismatchKernel kernel);
+int parse_mismatch_kernel(const char *name, MismatchKernel *kernel);
+
+/**
+* @brief Length of the common prefix of a[0...max-1] and b[0...max-1].
+*
+* The symbols are width bytes wide. The first differing byte belongs to
+* the first differing symbol, so the bytes are compared regardless of
+* the width: 8 at a time inline and with mismatch() past
+* MISMATCH_INLINE_BYTES, where the LCP is long enough to pay for the call.
+*
+* @return Returns the number of equal symbols.
+**/
+static inline idx_t common_prefix(const void *a, const void *b, idx_t max, size_t width) {
+    const unsigned char *x = a, *y = b;
+    size_t bytes = (size_t)max * width, i = 0;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; i + 8 <= bytes && i < MISMATCH_INLINE_BYTES; i += 8) {
+        uint64_t u, v;
+        memcpy(&u, x + i, 8);
+        memcpy(&v, y + i, 8);
+        if (u != v) {
+            return (idx_t)((i + __builtin_ctzll(u ^ v) / 8) / width);
+        }
+    }
+    if (i < bytes && i >= MISMATCH_INLINE_BYTES) {
+        return (idx_t)((i + mismatch(x + i, y + i, bytes - i)) / width);
+    }
+#endif
+    while (i < bytes && x[i] == y[i]) {
+        i++;
+    }
+    return (idx_t)(i / width);
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "parallel.h"
+#include "constants.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+// Per thread like the engine and the LPF algorithm (see liblpf.c)
+static __thread int thread_count = 1;
+
+struct parallel_job {
+    parallel_task task;
+    void *arg;
+    int id;
+    int chunks;
+};
+typedef struct parallel_job parallel_job;
+
+void set_thread_count(int threads) {
+    thread_count = threads < 1 ? 1 : (threads > MAX_THREADS ? MAX_THREADS : threads);
+}
+
+int get_thread_count() {
+    return thread_count;
+}
+
+/**
+* @brief Decide how many chunks a loop over total elements should be split into.
+*
+* Small inputs (and every level of the DC3 recursion that shrinks below
+* PARALLEL_MIN_LEN) are processed by the calling thread only, the cost
+* of starting threads would dominate otherwise.
+*
+* @param[in] total The number of elements the loop processes.
+*
+* @return Returns the number of chunks (1 means run serially).
+**/
+int parallel_chunks(idx_t total) {
+    if (thread_count <= 1 || total < PARALLEL_MIN_LEN) {
+        return 1;
+    }
+    idx_t chunks = total / (PARALLEL_MIN_LEN / 2);
+    return chunks < thread_count ? (int)chunks : thread_count;
+}
+
+/**
+* @brief First element of a chunk when total elements are split evenly.
+*
+* The end of chunk id is chunk_begin(total, id+1, chunks).
+**/
+idx_t chunk_begin(idx_t total, int id, int chunks) {
+    return (idx_t)((long long)total * id / chunks);
+}
+
+static void *parallel_worker(void *arg) {
+    parallel_job *job = arg;
+    job->task(job->arg, job->id, job->chunks);
+    return NULL;
+}
+
+/**
+* @brief Run task(arg, id, chunks) for every id in [0, chunks).
+*
+* Chunk 0 is executed by the calling thread, the rest by freshly started
+* threads. The function returns after all chunks are done. If a thread
+* can not be created its chunk is executed by the calling thread.
+*
+* @param[in] task The function to execute.
+* @param[in] arg Shared argument passed to every chunk.
+* @param[in] chunks The number of chunks (see parallel_chunks).
+**/
+void parallel_run(parallel_task task, void *arg, int chunks) {
+    if (chunks <= 1) {
+        task(arg, 0, 1);
+        return;
+    }
+
+    pthread_t threads[MAX_THREADS];
+    parallel_job jobs[MAX_THREADS];
+    int started[MAX_THREADS];
+
+    for (int i = 1; i < chunks; i++) {
+        jobs[i].task = task;
+        jobs[i].arg = arg;
+        jobs[i].id = i;
+        jobs[i].chunks = chunks;
+        started[i] = pthread_create(&threads[i], NULL, parallel_worker, &jobs[i]) == 0;
+        if (!started[i]) {
+            task(arg, i, chunks);
+        }
+    }
+
+    task(arg, 0, chunks);
+
+    for (int i = 1; i < chunks; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
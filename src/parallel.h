@@ -0,0 +1,14 @@
+#include "constants.h"
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+typedef void (*parallel_task)(void *arg, int id, int chunks);
+
+void set_thread_count(int threads);
+int get_thread_count();
+int parallel_chunks(idx_t total);
+idx_t chunk_begin(idx_t total, int id, int chunks);
+void parallel_run(parallel_task task, void *arg, int chunks);
+
+#endif
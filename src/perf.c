@@ -0,0 +1,129 @@
+#include "perf.h"
+#include "constants.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#define PERF_LINUX 1
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+struct perf_event_def {
+    uint32_t type;
+    uint64_t config;
+    const char *name;
+};
+typedef struct perf_event_def perf_event_def;
+
+#define CACHE_READ_MISS(cache) ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+#ifdef PERF_LINUX
+// In the order of PERF_CSV_HEADER
+static const perf_event_def events[PERF_EVENTS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D), "L1D misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "LLC misses"},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB), "dTLB misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch misses"},
+};
+#endif
+
+static int perf_fds[PERF_EVENTS];
+static int perf_opened = 0;
+
+/**
+* @brief Open the hardware counters of the calling process.
+*
+* Every counter is opened on its own (the PMU may not fit all of them
+* at once, the kernel multiplexes them and the reads are scaled) and
+* inherited by the threads created afterwards, so parallel_run is
+* counted once its threads are joined. Only user space is counted.
+* A counter which the kernel, the CPU or perf_event_paranoid refuses
+* is skipped and reads as -1.
+*
+* @return Returns the number of counters that could be opened.
+**/
+int perf_open() {
+    int opened = 0;
+
+    perf_close();
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        perf_fds[e] = -1;
+#ifdef PERF_LINUX
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[e].type;
+        attr.config = events[e].config;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        perf_fds[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        opened += perf_fds[e] >= 0;
+#endif
+    }
+    perf_opened = opened > 0;
+    return opened;
+}
+
+void perf_close() {
+    for (int e = 0; e < PERF_EVENTS && perf_opened; e++) {
+        if (perf_fds[e] >= 0) {
+            close(perf_fds[e]);
+        }
+        perf_fds[e] = -1;
+    }
+    perf_opened = 0;
+}
+
+int perf_available() {
+    return perf_opened;
+}
+
+/**
+* @brief The current value of every counter since perf_open.
+*
+* A multiplexed counter is scaled by the time it was enabled over
+* the time it was running. Counters which are not open are -1.
+**/
+void perf_read(perf_sample *s) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        s->values[e] = -1;
+        if (!perf_opened || perf_fds[e] < 0) {
+            continue;
+        }
+
+        uint64_t buf[3]; // value, time enabled, time running
+        if (read(perf_fds[e], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) {
+            continue;
+        }
+        if (buf[2] == 0) {
+            s->values[e] = 0;
+        } else if (buf[2] < buf[1]) {
+            s->values[e] = (long long)((double)buf[0] * buf[1] / buf[2]);
+        } else {
+            s->values[e] = (long long)buf[0];
+        }
+    }
+}
+
+// out = end - start, -1 where either is missing
+void perf_diff(perf_sample *out, const perf_sample *end, const perf_sample *start) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        out->values[e] = end->values[e] < 0 || start->values[e] < 0 ? -1 : end->values[e] - start->values[e];
+    }
+}
+
+const char *perf_event_name(int event) {
+#ifdef PERF_LINUX
+    return event >= 0 && event < PERF_EVENTS ? events[event].name : "unknown";
+#else
+    return "unknown";
+#endif
+}
@@ -0,0 +1,18 @@
+#include "constants.h"
+
+#ifndef PERF_H
+#define PERF_H
+
+struct perf_sample {
+    long long values[PERF_EVENTS]; // -1 if the counter is not available
+};
+typedef struct perf_sample perf_sample;
+
+int perf_open();
+void perf_close();
+int perf_available();
+void perf_read(perf_sample *s);
+void perf_diff(perf_sample *out, const perf_sample *end, const perf_sample *start);
+const char *perf_event_name(int event);
+
+#endif
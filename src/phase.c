@@ -0,0 +1,240 @@
+#include "phase.h"
+#include "perf.h"
+#include "util.h"
+#include "constants.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+
+struct phase_frame {
+    Phase phase;
+    long long arg;
+    double start;
+    perf_sample counters;
+};
+typedef struct phase_frame phase_frame;
+
+static int phase_timing = 0;
+
+// Every thread times its own calls, the trace file is shared
+static __thread phase_frame frames[PHASE_STACK];
+static __thread int frame_count = 0;
+static __thread int open_phases[PHASE_COUNT];
+static __thread phase_stats stats;
+static __thread int trace_tid = 0;
+
+// A recursion level records the memory until the next level starts
+static void record_peak(const phase_frame *f) {
+    if (stats.current_bytes > stats.phase_peak_bytes[f->phase]) {
+        stats.phase_peak_bytes[f->phase] = stats.current_bytes;
+    }
+    int innermost = f->arg >= open_phases[PHASE_RECURSION];
+    if (f->phase == PHASE_RECURSION && innermost && f->arg < PHASE_MAX_DEPTH && stats.current_bytes > stats.depth_peak_bytes[f->arg]) {
+        stats.depth_peak_bytes[f->arg] = stats.current_bytes;
+    }
+}
+
+static FILE *trace_file = NULL;
+static double trace_start = 0;
+static int trace_events = 0;
+static int trace_threads = 0;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+* @brief Turn the phase timers on or off.
+*
+* They are on while a trace is open or the counters are open (perf.h)
+* as well. Off, phase_begin and phase_end return right away.
+**/
+void set_phase_timing(int enabled) {
+    phase_timing = enabled;
+}
+
+int get_phase_timing() {
+    return phase_timing || trace_file != NULL || perf_available();
+}
+
+void phase_begin(Phase phase) {
+    phase_begin_arg(phase, -1);
+}
+
+/**
+* @brief Start a phase of the calling thread.
+*
+* Phases nest and every phase_begin needs its phase_end. The argument
+* is shown in the trace (the pass of a radix pass). The level of a
+* recursion is the number of recursions already open plus one.
+*
+* @param[in] phase The phase.
+* @param[in] arg The argument of the phase, -1 for none.
+**/
+void phase_begin_arg(Phase phase, long long arg) {
+    if (!get_phase_timing()) {
+        return;
+    }
+    if (frame_count == PHASE_STACK) {
+        fprintf(stderr, "Phase stack exhausted at %s\n", phase_name(phase));
+        abort();
+    }
+
+    phase_frame *f = &frames[frame_count++];
+    f->phase = phase;
+    f->arg = phase == PHASE_RECURSION ? open_phases[PHASE_RECURSION] + 1 : arg;
+    record_peak(f);
+    perf_read(&f->counters);
+    open_phases[phase]++;
+    f->start = wall_time();
+}
+
+/**
+* @brief Account bytes allocated (freed if negative) by the calling thread.
+*
+* The workspace and mem_alloc call it for every allocation, every
+* open phase and recursion level keeps the highest total it saw.
+**/
+void phase_memory(long long bytes) {
+    if (!get_phase_timing()) {
+        return;
+    }
+    stats.current_bytes += bytes;
+    if (bytes <= 0) {
+        return;
+    }
+    if (stats.current_bytes > stats.peak_bytes) {
+        stats.peak_bytes = stats.current_bytes;
+    }
+    for (int i = 0; i < frame_count; i++) {
+        record_peak(&frames[i]);
+    }
+}
+
+static void trace_event(const phase_frame *f, double end) {
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file != NULL) {
+        if (trace_tid == 0) {
+            trace_tid = ++trace_threads;
+        }
+        fprintf(trace_file, "%s{\"name\": \"%s\", \"cat\": \"lpf\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+            trace_events++ ? ",\n" : "", phase_name(f->phase), trace_tid, (f->start - trace_start) * 1e6, (end - f->start) * 1e6);
+        if (f->arg >= 0) {
+            fprintf(trace_file, ", \"args\": {\"%s\": %lld}", f->phase == PHASE_RECURSION ? "depth" : "pass", f->arg);
+        }
+        fprintf(trace_file, "}");
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+/**
+* @brief End the innermost phase, which has to be phase.
+**/
+void phase_end(Phase phase) {
+    if (!get_phase_timing() || frame_count == 0) {
+        return;
+    }
+    double end = wall_time();
+    phase_frame *f = &frames[--frame_count];
+    if (f->phase != phase) {
+        fprintf(stderr, "Phase %s ended inside %s\n", phase_name(phase), phase_name(f->phase));
+        abort();
+    }
+
+    perf_sample now, delta;
+    perf_read(&now);
+    perf_diff(&delta, &now, &f->counters);
+
+    open_phases[phase]--;
+    stats.calls[phase]++;
+    if (open_phases[phase] == 0) {
+        stats.seconds[phase] += end - f->start;
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            stats.counters[phase].values[e] = delta.values[e] < 0 ? -1 : stats.counters[phase].values[e] + delta.values[e];
+        }
+    }
+    if (phase == PHASE_RECURSION && f->arg < PHASE_MAX_DEPTH) {
+        stats.depth_seconds[f->arg] += end - f->start;
+        stats.max_depth = f->arg > stats.max_depth ? (int)f->arg : stats.max_depth;
+    }
+    if (trace_file != NULL) {
+        trace_event(f, end);
+    }
+}
+
+/**
+* @brief The phase times, counters and memory of the calling thread since reset_phase_stats.
+**/
+void get_phase_stats(phase_stats *s) {
+    *s = stats;
+}
+
+// The memory is counted from zero again, arrays still held are not
+void reset_phase_stats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+const char *phase_name(Phase phase) {
+    switch (phase) {
+        case PHASE_SA:
+            return "SA";
+        case PHASE_TUPLES:
+            return "tuples";
+        case PHASE_RADIX_PASS:
+            return "radix pass";
+        case PHASE_NAMING:
+            return "naming";
+        case PHASE_RECURSION:
+            return "recursion";
+        case PHASE_T0_SORT:
+            return "t0 sort";
+        case PHASE_MERGE:
+            return "merge";
+        case PHASE_ISA:
+            return "ISA";
+        case PHASE_LCP:
+            return "LCP";
+        case PHASE_BINODE:
+            return "binode";
+        case PHASE_LPF:
+            return "LPF";
+        case PHASE_ENCODE:
+            return "encode";
+        default:
+            return "unknown";
+    }
+}
+
+/**
+* @brief Write every phase from now on as a Chrome trace event to path.
+*
+* The file is a JSON array of complete ("X") events, it can be loaded
+* into chrome://tracing or Perfetto after phase_trace_close.
+*
+* @return Returns 1 if the file could be created, 0 otherwise.
+**/
+int phase_trace_open(const char *path) {
+    phase_trace_close();
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        perror("Error opening trace file");
+        return 0;
+    }
+    fprintf(file, "[\n");
+
+    pthread_mutex_lock(&trace_lock);
+    trace_start = wall_time();
+    trace_events = 0;
+    trace_file = file;
+    pthread_mutex_unlock(&trace_lock);
+    return 1;
+}
+
+void phase_trace_close() {
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file != NULL) {
+        fprintf(trace_file, "\n]\n");
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
@@ -0,0 +1,34 @@
+#include "constants.h"
+#include "perf.h"
+
+#ifndef PHASE_H
+#define PHASE_H
+
+// Times of one thread since reset_phase_stats. A phase is counted once
+// per outermost occurrence, e.g. the radix passes of all DC3 levels.
+struct phase_stats {
+    double seconds[PHASE_COUNT];
+    long long calls[PHASE_COUNT];
+    perf_sample counters[PHASE_COUNT];      // -1 without perf_open
+    double depth_seconds[PHASE_MAX_DEPTH];  // Recursion level d >= 1 including its own recursion
+    int max_depth;
+    long long current_bytes;                // Allocated through the workspace and mem_alloc (workspace.h)
+    long long peak_bytes;
+    long long phase_peak_bytes[PHASE_COUNT];    // Highest current_bytes while the phase was open
+    long long depth_peak_bytes[PHASE_MAX_DEPTH];   // Highest while level d was the innermost
+};
+typedef struct phase_stats phase_stats;
+
+void set_phase_timing(int enabled);
+int get_phase_timing();
+void phase_begin(Phase phase);
+void phase_begin_arg(Phase phase, long long arg);
+void phase_end(Phase phase);
+void phase_memory(long long bytes);
+void get_phase_stats(phase_stats *stats);
+void reset_phase_stats();
+const char *phase_name(Phase phase);
+int phase_trace_open(const char *path);
+void phase_trace_close();
+
+#endif
@@ -1,82 +1,516 @@
 #include "radix.h"
+#include "parallel.h"
 #include "constants.h"
+#include "workspace.h"
+#include "phase.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
-void print_sorting(int (*values)[TUPLE_SIZE], int *sorting, int n) {
-    printf("Sorting len: %d\n", n);
-    for (int i = 0; i < n; i++) {
-        int idx = sorting[i];
-        printf("[%d]: %d %d %d\n", idx, values[idx][0], values[idx][1], values[idx][2]);
+static RadixKind radix_kind = RADIX_PACKED;
+
+static int packed_key_bits(idx_t key_range, idx_t blocks, int *sym_bits, int *index_bits);
+static int packed_max_digit_bits(idx_t len);
+static idx_t *radix_sort_packed(workspace *ws, tuple_info *tinfo, int sym_bits, int index_bits);
+
+void print_sorting(idx_t (*values)[TUPLE_SIZE], idx_t *sorting, idx_t n) {
+    printf("Sorting len: %" PRIdx "\n", n);
+    for (idx_t i = 0; i < n; i++) {
+        idx_t idx = sorting[i];
+        printf("[%" PRIdx "]: %" PRIdx " %" PRIdx " %" PRIdx "\n", idx, values[idx][0], values[idx][1], values[idx][2]);
     }
 }
 
-void print_values(int (*values)[TUPLE_SIZE], int n) {
-    printf("Sorting len: %d\n", n);
-    for (int i = 0; i < n; i++) {
-        int idx = i;
-        printf("%d %d %d\n", values[idx][0], values[idx][1], values[idx][2]);
+void print_values(idx_t (*values)[TUPLE_SIZE], idx_t n) {
+    printf("Sorting len: %" PRIdx "\n", n);
+    for (idx_t i = 0; i < n; i++) {
+        idx_t idx = i;
+        printf("%" PRIdx " %" PRIdx " %" PRIdx "\n", values[idx][0], values[idx][1], values[idx][2]);
     }
 }
 
 /**
 * @brief Radix sort for the tuple structure.
 *
-* @param[in,out] tinfo The tuple info structure. The tuple_sorting is set at the end.
+* The passes alternate between tinfo->tuple_sorting and a temporary
+* array such that the last pass writes into tinfo->tuple_sorting.
+*
+* @param[in,out] ws Workspace for the temporary arrays.
+* @param[in,out] tinfo The tuple info structure. The tuple_sorting (preallocated) is set at the end.
 * @param[in] stages The number of loops to perform counting sort starting from the last elements.
 *
+* Full triples whose names and index fit into 64 bits are sorted as
+* packed keys (radix_sort_packed) unless set_radix_kind selected the tuples.
+*
 **/
-int *radix_sort(tuple_info *tinfo, int stages) {
-    int *prev_sorting = NULL, *sorting = NULL;
-    int n = tinfo->total_blocks * TUPLE_SIZE > MIN_LEN ? tinfo->total_blocks * TUPLE_SIZE : MIN_LEN;
-    int out_len = tinfo->total_blocks;
+idx_t *radix_sort(workspace *ws, tuple_info *tinfo, int stages) {
+    int sym_bits, index_bits;
+    if (radix_kind == RADIX_PACKED && stages == TUPLE_SIZE && packed_key_bits(tinfo->key_range, tinfo->total_blocks, &sym_bits, &index_bits)) {
+        return radix_sort_packed(ws, tinfo, sym_bits, index_bits);
+    }
+
+    idx_t n = tinfo->key_range;
+    idx_t out_len = tinfo->total_blocks;
+    size_t mark = ws_mark(ws);
+    idx_t *prev_sorting = NULL, *sorting = tinfo->tuple_sorting;
+    idx_t *tmp = ws_alloc(ws, out_len * sizeof(idx_t));
+
+    if (stages % 2 == 0) {
+        sorting = tmp;
+        tmp = tinfo->tuple_sorting;
+    }
     
-    for (int i = stages-1; i >= 0; i--) {
-        sorting = counting_sort(tinfo->values, prev_sorting, n, out_len, i);
-        free(prev_sorting);
+    for (idx_t i = stages-1; i >= 0; i--) {
+        phase_begin_arg(PHASE_RADIX_PASS, stages-1 - i);
+        counting_sort(ws, tinfo->values, prev_sorting, sorting, n, out_len, i);
+        phase_end(PHASE_RADIX_PASS);
         prev_sorting = sorting;
+        sorting = tmp;
+        tmp = prev_sorting;
     }
+
+    ws_release(ws, mark);
+    return tinfo->tuple_sorting;
+}
+
+// key_range is an upper bound, a smaller actual range may fit into the packed keys
+// with fewer digits, so the digits and buckets are bounded from the key bits of the bound
+size_t radix_sort_workspace_size(idx_t total_blocks, idx_t key_range) {
+    size_t tuples = WS_SIZE(total_blocks * sizeof(idx_t)) + counting_sort_workspace_size(key_range, total_blocks);
+    int sym_bits, index_bits;
+    packed_key_bits(key_range, total_blocks, &sym_bits, &index_bits);
+
+    int key_bits = TUPLE_SIZE * sym_bits;
+    int max_bits = packed_max_digit_bits(total_blocks);
+    size_t digits = (key_bits + max_bits - 1) / max_bits;
+    size_t buckets = (size_t)1 << (key_bits < max_bits ? key_bits : max_bits);
+    size_t chunks = parallel_chunks(total_blocks);
+    size_t packed = 2 * WS_SIZE(total_blocks * sizeof(uint64_t)) + WS_SIZE(chunks * digits * buckets * sizeof(idx_t))
+        + WS_SIZE(chunks * buckets * RADIX_WC_ENTRIES * sizeof(uint64_t)) + WS_SIZE(chunks * buckets);
+
+    return packed > tuples ? packed : tuples;
+}
+
+void set_radix_kind(RadixKind kind) {
+    radix_kind = kind;
+}
+
+RadixKind get_radix_kind() {
+    return radix_kind;
+}
+
+const char *radix_kind_name(RadixKind kind) {
+    return kind == RADIX_TUPLES ? "tuples" : "packed";
+}
+
+int parse_radix_kind(const char *name, RadixKind *kind) {
+    if (!strcmp(name, "packed")) {
+        *kind = RADIX_PACKED;
+        return 1;
+    }
+    if (!strcmp(name, "tuples")) {
+        *kind = RADIX_TUPLES;
+        return 1;
+    }
+    return 0;
+}
+
+// The widest digit for len keys, a short input takes more passes over fewer buckets
+static int packed_max_digit_bits(idx_t len) {
+    int bits = 64 - __builtin_clzll((unsigned long long)len | 1);
+    return bits < RADIX_MIN_DIGIT_BITS ? RADIX_MIN_DIGIT_BITS : (bits > RADIX_MAX_DIGIT_BITS ? RADIX_MAX_DIGIT_BITS : bits);
+}
+
+// Bits of a name and of a tuple index, 0 if the packed (t0, t1, t2, index) does not fit into 64 bits
+static int packed_key_bits(idx_t key_range, idx_t blocks, int *sym_bits, int *index_bits) {
+    *sym_bits = 64 - __builtin_clzll((unsigned long long)(key_range - 1) | 1);
+    *index_bits = 64 - __builtin_clzll((unsigned long long)(blocks - 1) | 1);
+    return TUPLE_SIZE * *sym_bits + *index_bits <= 64;
+}
+
+struct packed_sort {
+    tuple_info *tinfo;
+    uint64_t *src;
+    uint64_t *dst;
+    idx_t *count;           // [chunk][digit][bucket], the bucket offsets of a chunk during its pass
+    uint64_t *buffers;      // [chunk][bucket][RADIX_WC_ENTRIES]
+    unsigned char *fill;    // [chunk][bucket]
+    idx_t buckets;
+    int sym_bits;
+    int index_bits;
+    int digit_bits;
+    int digits;
+    int digit;
+};
+typedef struct packed_sort packed_sort;
+
+// Packs the triples of a chunk and counts every digit in the same read
+static void packed_keys_task(void *arg, int id, int chunks) {
+    packed_sort *p = arg;
+    idx_t (*values)[TUPLE_SIZE] = p->tinfo->values;
+    idx_t *count = p->count + (size_t)id * p->digits * p->buckets;
+    idx_t end = chunk_begin(p->tinfo->total_blocks, id+1, chunks);
+
+    memset(count, 0, (size_t)p->digits * p->buckets * sizeof(idx_t));
+    for (idx_t j = chunk_begin(p->tinfo->total_blocks, id, chunks); j < end; j++) {
+        uint64_t key = 0;
+        for (int s = 0; s < TUPLE_SIZE; s++) {
+            key = key << p->sym_bits | (uint64_t)values[j][s];
+        }
+        p->src[j] = key << p->index_bits | (uint64_t)j;
+
+        for (int d = 0; d < p->digits; d++) {
+            count[(size_t)d * p->buckets + (key & (p->buckets - 1))]++;
+            key >>= p->digit_bits;
+        }
+    }
+}
+
+// Counts the current digit again, after a pass the chunks hold other keys than the ones packed
+static void packed_count_task(void *arg, int id, int chunks) {
+    packed_sort *p = arg;
+    idx_t *count = p->count + ((size_t)id * p->digits + p->digit) * p->buckets;
+    int shift = p->index_bits + p->digit * p->digit_bits;
+    idx_t end = chunk_begin(p->tinfo->total_blocks, id+1, chunks);
+
+    memset(count, 0, p->buckets * sizeof(idx_t));
+    for (idx_t j = chunk_begin(p->tinfo->total_blocks, id, chunks); j < end; j++) {
+        count[(p->src[j] >> shift) & (p->buckets - 1)]++;
+    }
+}
+
+// Turns the histograms of the current digit into offsets, bucket-major then chunk order.
+// Returns 0 if every key has the same digit, the pass would not move anything then.
+static int packed_offsets(packed_sort *p, int chunks) {
+    idx_t offset = 0;
+    size_t stride = (size_t)p->digits * p->buckets;
+    idx_t *count = p->count + (size_t)p->digit * p->buckets;
+
+    for (idx_t b = 0; b < p->buckets; b++) {
+        idx_t total = 0;
+        for (int t = 0; t < chunks; t++) {
+            total += count[t * stride + b];
+        }
+        if (total == p->tinfo->total_blocks) {
+            return 0;
+        }
+    }
+
+    for (idx_t b = 0; b < p->buckets; b++) {
+        for (int t = 0; t < chunks; t++) {
+            idx_t tmp = count[t * stride + b];
+            count[t * stride + b] = offset;
+            offset += tmp;
+        }
+    }
+    return 1;
+}
+
+// Keys go to a cache-line buffer of their bucket first and are written out a full line at a time
+static void packed_scatter_task(void *arg, int id, int chunks) {
+    packed_sort *p = arg;
+    idx_t *offset = p->count + ((size_t)id * p->digits + p->digit) * p->buckets;
+    uint64_t *buffers = p->buffers + (size_t)id * p->buckets * RADIX_WC_ENTRIES;
+    unsigned char *fill = p->fill + (size_t)id * p->buckets;
+    int shift = p->index_bits + p->digit * p->digit_bits;
+    idx_t end = chunk_begin(p->tinfo->total_blocks, id+1, chunks);
+
+    memset(fill, 0, p->buckets);
+    for (idx_t j = chunk_begin(p->tinfo->total_blocks, id, chunks); j < end; j++) {
+        uint64_t key = p->src[j];
+        idx_t b = (key >> shift) & (p->buckets - 1);
+        uint64_t *buffer = buffers + (size_t)b * RADIX_WC_ENTRIES;
+
+        buffer[fill[b]++] = key;
+        if (fill[b] == RADIX_WC_ENTRIES) {
+            memcpy(p->dst + offset[b], buffer, RADIX_WC_ENTRIES * sizeof(uint64_t));
+            offset[b] += RADIX_WC_ENTRIES;
+            fill[b] = 0;
+        }
+    }
+
+    for (idx_t b = 0; b < p->buckets; b++) {
+        memcpy(p->dst + offset[b], buffers + (size_t)b * RADIX_WC_ENTRIES, fill[b] * sizeof(uint64_t));
+    }
+}
+
+static void packed_unpack_task(void *arg, int id, int chunks) {
+    packed_sort *p = arg;
+    uint64_t mask = ((uint64_t)1 << p->index_bits) - 1;
+    idx_t end = chunk_begin(p->tinfo->total_blocks, id+1, chunks);
+
+    for (idx_t j = chunk_begin(p->tinfo->total_blocks, id, chunks); j < end; j++) {
+        p->tinfo->tuple_sorting[j] = (idx_t)(p->src[j] & mask);
+    }
+}
+
+/**
+* @brief Radix sort of the triples as packed 64-bit keys.
+*
+* Each triple becomes (t0, t1, t2, index) in one word, so a pass moves
+* 8 bytes and needs no indirection through the previous sorting. The
+* keys are sorted LSD with digits of up to RADIX_MAX_DIGIT_BITS bits
+* (at most 3 passes instead of one per name).
+*
+* The histograms of all digits are counted while the keys are packed,
+* and a digit with a single bucket is skipped. With several chunks a
+* chunk holds other keys after each pass, so its later digits are
+* counted again.
+*
+* The scatter goes through one cache line buffer per bucket, so the
+* random writes touch one line (and page) per RADIX_WC_ENTRIES keys.
+* The order is the same as radix_sort.
+*
+* @param[in,out] ws Workspace for the keys, histograms and buffers.
+* @param[in,out] tinfo The tuple info structure, tuple_sorting is set.
+* @param[in] sym_bits Bits of a name.
+* @param[in] index_bits Bits of a tuple index.
+*
+* @return Returns tinfo->tuple_sorting.
+**/
+static idx_t *radix_sort_packed(workspace *ws, tuple_info *tinfo, int sym_bits, int index_bits) {
+    idx_t len = tinfo->total_blocks;
+    int chunks = parallel_chunks(len);
+    int key_bits = TUPLE_SIZE * sym_bits;
+    int max_bits = packed_max_digit_bits(len);
+    size_t mark = ws_mark(ws);
+    packed_sort p;
+
+    p.tinfo = tinfo;
+    p.sym_bits = sym_bits;
+    p.index_bits = index_bits;
+    p.digits = (key_bits + max_bits - 1) / max_bits;
+    p.digit_bits = (key_bits + p.digits - 1) / p.digits;
+    p.buckets = (idx_t)1 << p.digit_bits;
+    p.src = ws_alloc(ws, len * sizeof(uint64_t));
+    p.dst = ws_alloc(ws, len * sizeof(uint64_t));
+    p.count = ws_alloc(ws, (size_t)chunks * p.digits * p.buckets * sizeof(idx_t));
+    p.buffers = ws_alloc(ws, (size_t)chunks * p.buckets * RADIX_WC_ENTRIES * sizeof(uint64_t));
+    p.fill = ws_alloc(ws, (size_t)chunks * p.buckets);
+
+    parallel_run(packed_keys_task, &p, chunks);
+
+    int moved = 0;
+    for (p.digit = 0; p.digit < p.digits; p.digit++) {
+        phase_begin_arg(PHASE_RADIX_PASS, p.digit);
+        if (moved && chunks > 1) {
+            parallel_run(packed_count_task, &p, chunks);
+        }
+        if (!packed_offsets(&p, chunks)) {
+            phase_end(PHASE_RADIX_PASS);
+            continue;
+        }
+        parallel_run(packed_scatter_task, &p, chunks);
+        phase_end(PHASE_RADIX_PASS);
+        moved = 1;
+        uint64_t *tmp = p.src;
+        p.src = p.dst;
+        p.dst = tmp;
+    }
+
+    parallel_run(packed_unpack_task, &p, chunks);
+
+    ws_release(ws, mark);
+    return tinfo->tuple_sorting;
+}
+
+struct sort_pass {
+    idx_t (*values)[TUPLE_SIZE];
+    idx_t *src;
+    idx_t *dst;
+    idx_t *count;
+    idx_t *range_sum;
+    idx_t out_len;
+    int stage;
+    int shift;
+    idx_t mask;
+    idx_t buckets;
+};
+typedef struct sort_pass sort_pass;
+
+static inline idx_t pass_key(sort_pass *p, idx_t j) {
+    idx_t idx = p->src == NULL ? j : p->src[j];
+    return (p->values[idx][p->stage] >> p->shift) & p->mask;
+}
+
+static void histogram_task(void *arg, int id, int chunks) {
+    sort_pass *p = arg;
+    idx_t *count = p->count + (long long)id * p->buckets;
+    idx_t end = chunk_begin(p->out_len, id+1, chunks);
+
+    for (idx_t b = 0; b < p->buckets; b++) {
+        count[b] = 0;
+    }
+    for (idx_t j = chunk_begin(p->out_len, id, chunks); j < end; j++) {
+        count[pass_key(p, j)]++;
+    }
+}
+
+// Sum of the histograms of all chunks over this chunk's bucket range
+static void range_sum_task(void *arg, int id, int chunks) {
+    sort_pass *p = arg;
+    idx_t end = chunk_begin(p->buckets, id+1, chunks);
+    idx_t sum = 0;
+
+    for (idx_t b = chunk_begin(p->buckets, id, chunks); b < end; b++) {
+        for (int t = 0; t < chunks; t++) {
+            sum += p->count[(long long)t * p->buckets + b];
+        }
+    }
+    p->range_sum[id] = sum;
+}
+
+// Turns the histograms into starting offsets, bucket-major then chunk order
+static void offsets_task(void *arg, int id, int chunks) {
+    sort_pass *p = arg;
+    idx_t end = chunk_begin(p->buckets, id+1, chunks);
+    idx_t offset = p->range_sum[id];
+
+    for (idx_t b = chunk_begin(p->buckets, id, chunks); b < end; b++) {
+        for (int t = 0; t < chunks; t++) {
+            idx_t *c = p->count + (long long)t * p->buckets + b;
+            idx_t tmp = *c;
+            *c = offset;
+            offset += tmp;
+        }
+    }
+}
+
+static void scatter_task(void *arg, int id, int chunks) {
+    sort_pass *p = arg;
+    idx_t *count = p->count + (long long)id * p->buckets;
+    idx_t end = chunk_begin(p->out_len, id+1, chunks);
+
+    for (idx_t j = chunk_begin(p->out_len, id, chunks); j < end; j++) {
+        idx_t idx = p->src == NULL ? j : p->src[j];
+        p->dst[count[pass_key(p, j)]++] = idx;
+    }
+}
+
+static void sort_pass_run(sort_pass *p, int chunks) {
+    parallel_run(histogram_task, p, chunks);
+    parallel_run(range_sum_task, p, chunks);
+
+    idx_t offset = 0;
+    for (int t = 0; t < chunks; t++) {
+        idx_t tmp = p->range_sum[t];
+        p->range_sum[t] = offset;
+        offset += tmp;
+    }
+
+    parallel_run(offsets_task, p, chunks);
+    parallel_run(scatter_task, p, chunks);
+}
+
+/**
+* @brief Multi-threaded version of counting_sort.
+*
+* Every chunk of the input builds its own histogram, the histograms
+* are combined with a parallel prefix sum (bucket-major, chunk order)
+* and each chunk scatters its elements to their final positions.
+* Since chunks are placed in input order the sort stays stable and
+* the result is identical to the single-threaded counting_sort.
+*
+* Keys larger than 2^PARALLEL_DIGIT_BITS are sorted in several stable passes
+* (lowest digit first) so the per-thread histograms stay small.
+**/
+static idx_t *counting_sort_parallel(workspace *ws, idx_t (*values)[TUPLE_SIZE], idx_t *prev_sorting, idx_t *sorting, idx_t n, idx_t out_len, int stage, int chunks) {
+    idx_t digit = 1 << PARALLEL_DIGIT_BITS;
+    idx_t buckets = n > digit ? digit : n;
+    size_t mark = ws_mark(ws);
+    idx_t *count = ws_alloc(ws, (size_t)chunks * buckets * sizeof(idx_t));
+    idx_t range_sum[MAX_THREADS];
+
+    sort_pass p = {values, prev_sorting, sorting, count, range_sum, out_len, stage, 0, -1, n};
+
+    if (n <= digit) {
+        sort_pass_run(&p, chunks);
+    } else {
+        int digits = 0;
+        for (idx_t max = n - 1; max > 0; max >>= PARALLEL_DIGIT_BITS) {
+            digits++;
+        }
+
+        // The last pass has to end in sorting
+        idx_t *tmp = ws_alloc(ws, out_len * sizeof(idx_t));
+        idx_t *dst = digits % 2 ? sorting : tmp;
+        for (int d = 0; d < digits; d++) {
+            p.dst = dst;
+            p.shift = d * PARALLEL_DIGIT_BITS;
+            p.mask = d < digits-1 ? digit - 1 : -1;
+            p.buckets = d < digits-1 ? digit : ((n - 1) >> p.shift) + 1;
+            sort_pass_run(&p, chunks);
+
+            p.src = dst;
+            dst = dst == tmp ? sorting : tmp;
+        }
+    }
+
+    ws_release(ws, mark);
     return sorting;
 }
 
+/**
+* @brief Workspace needed by one counting_sort call.
+*
+* @param[in] n The number of individual values.
+* @param[in] out_len The output array size.
+**/
+size_t counting_sort_workspace_size(idx_t n, idx_t out_len) {
+    idx_t digit = 1 << PARALLEL_DIGIT_BITS;
+    int chunks = parallel_chunks(out_len);
+
+    if (chunks == 1) {
+        return WS_SIZE(n * sizeof(idx_t));
+    }
+    return WS_SIZE((size_t)chunks * (n > digit ? digit : n) * sizeof(idx_t)) + (n > digit ? WS_SIZE(out_len * sizeof(idx_t)) : 0);
+}
+
 /**
 * @brief Counting sort which performs one sorting iteration for the radix sort.
 *
+* @param[in,out] ws Workspace for the bucket counts.
 * @param[in] values The tuples to perform the sorting on.
 * @param[in] prev_sorting The previous sorting for the tuples (on the old index). ID if this is the first round.
-* @param[in] n The number of individual values (tuple count * TUPLE_SIZE).
+* @param[out] sorting The output array (must not be prev_sorting).
+* @param[in] n The number of individual values (the values are in [0, n)).
 * @param[in] out_len The output array size.
 * @param[in] stage Index in the value array.
 *
+* @return Returns sorting.
 **/
-int *counting_sort(int (*values)[TUPLE_SIZE], int *prev_sorting, int n, int out_len, int stage) {
-    int *count = calloc(n, sizeof(int));
-    int *sorting = calloc(out_len, sizeof(int));
+idx_t *counting_sort(workspace *ws, idx_t (*values)[TUPLE_SIZE], idx_t *prev_sorting, idx_t *sorting, idx_t n, idx_t out_len, int stage) {
+    int chunks = parallel_chunks(out_len);
+    if (chunks > 1) {
+        return counting_sort_parallel(ws, values, prev_sorting, sorting, n, out_len, stage, chunks);
+    }
+
+    size_t mark = ws_mark(ws);
+    idx_t *count = ws_calloc(ws, n * sizeof(idx_t));
     
-    for (int j = 0; j < out_len; j++) {
+    for (idx_t j = 0; j < out_len; j++) {
         count[values[j][stage]]++;
     }
 
-    for (int j = 1; j < n; j++) {
+    for (idx_t j = 1; j < n; j++) {
         count[j] += count[j-1];
     }
 
     if (prev_sorting == NULL) {
-        for (int j = out_len-1; j >= 0; j--) {
-            int tmp = values[j][stage];
+        for (idx_t j = out_len-1; j >= 0; j--) {
+            idx_t tmp = values[j][stage];
             count[tmp]--;
             sorting[count[tmp]] = j; 
         }
     } else {
-        for (int j = out_len-1; j >= 0; j--) {
-            int tmp = values[prev_sorting[j]][stage];
+        for (idx_t j = out_len-1; j >= 0; j--) {
+            idx_t tmp = values[prev_sorting[j]][stage];
             count[tmp]--;
             sorting[count[tmp]] = prev_sorting[j]; 
         }
     }
 
-    free(count);
+    ws_release(ws, mark);
     return sorting;
 }
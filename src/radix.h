@@ -1,9 +1,16 @@
 #include "constants.h"
+#include "workspace.h"
 
 #ifndef RADIX_H
 #define RADIX_H
 
-int *radix_sort(tuple_info *tinfo, int stages);
-int *counting_sort(int (*values)[TUPLE_SIZE], int *prev_sorting, int n, int out_len, int stage);
+idx_t *radix_sort(workspace *ws, tuple_info *tinfo, int stages);
+idx_t *counting_sort(workspace *ws, idx_t (*values)[TUPLE_SIZE], idx_t *prev_sorting, idx_t *sorting, idx_t n, idx_t out_len, int stage);
+size_t radix_sort_workspace_size(idx_t total_blocks, idx_t key_range);
+size_t counting_sort_workspace_size(idx_t n, idx_t out_len);
+void set_radix_kind(RadixKind kind);
+RadixKind get_radix_kind();
+const char *radix_kind_name(RadixKind kind);
+int parse_radix_kind(const char *name, RadixKind *kind);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "sais.h"
+#include "text.h"
+#include "constants.h"
+#include "workspace.h"
+#include "phase.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define L_TYPE 0
+#define S_TYPE 1
+
+#define IS_LMS(t, i) ((i) > 0 && (t)[i] == S_TYPE && (t)[(i)-1] == L_TYPE)
+
+static void sais_idx(const idx_t *str, workspace *ws, idx_t *sa, idx_t str_len, idx_t K);
+
+#define SYMBOL_KERNELS "sais_kernels.inc"
+#include "symbol_template.h"
+
+// The reduced string has at most (n-1)/2 letters and as many names
+static size_t sais_workspace_size(idx_t str_len, idx_t K) {
+    if (str_len <= 1) {
+        return 0;
+    }
+    return WS_SIZE(str_len) + WS_SIZE(K * sizeof(idx_t)) + sais_workspace_size((str_len-1)/2, (str_len-1)/2);
+}
+
+/**
+* @brief Compute the suffix array for a given string using induced sorting.
+*
+* This is an implementation of SA-IS by Ge Nong, Sen Zhang and Wai Hong Chan:
+* https://doi.org/10.1109/DCC.2009.42.
+* Suffixes are classified as S-type (smaller than the next suffix) or L-type,
+* the leftmost S-type positions (LMS) are sorted first and the order of all
+* other suffixes is induced from them with two scans over SA.
+* Only the type array (1 byte per letter) and the buckets are needed on top
+* of SA which is reused for the recursion.
+*
+* The buckets are indexed by the letters, so the alphabet bound of the
+* text sizes them. The result is the same as for suffix_array().
+*
+* @param[in] t The input text.
+*
+* @return Returns a pointer to the suffix array.
+**/
+idx_t *suffix_array_sais(const text *t) {
+    workspace *ws = create_workspace(suffix_array_sais_workspace_size(t));
+    idx_t *sa = mem_alloc(t->len * sizeof(idx_t));
+
+    suffix_array_sais_ws(ws, t, sa);
+
+    cleanup_workspace(ws);
+    return sa;
+}
+
+/**
+* @brief Compute the suffix array with SA-IS using a workspace for the temporaries.
+*
+* @param[in,out] ws The workspace.
+* @param[in] t The input text.
+* @param[out] sa Output array of size t->len.
+*
+* @return Returns sa.
+**/
+idx_t *suffix_array_sais_ws(workspace *ws, const text *t, idx_t *sa) {
+    ensure_workspace(ws, sais_workspace_size(t->len, t->alphabet));
+    TEXT_DISPATCH(t, sais, ws, sa, t->len, t->alphabet);
+    return sa;
+}
+
+size_t suffix_array_sais_workspace_size(const text *t) {
+    return sais_workspace_size(t->len, t->alphabet);
+}
@@ -0,0 +1,12 @@
+#include "constants.h"
+#include "workspace.h"
+#include "text.h"
+
+#ifndef SAIS_H
+#define SAIS_H
+
+idx_t *suffix_array_sais(const text *t);
+idx_t *suffix_array_sais_ws(workspace *ws, const text *t, idx_t *sa);
+size_t suffix_array_sais_workspace_size(const text *t);
+
+#endif
@@ -1,5 +1,10 @@
+#include "sais.h"
+#include "text.h"
+#include "util.h"
+#include "phase.h"
 #include "tuple.h"
 #include "radix.h"
+#include "mismatch.h"
 #include "constants.h"
 #include "suffix_array.h"
 
@@ -8,6 +13,23 @@
 #include <stdio.h>
 #include <byteswap.h>
 
+#define SYMBOL_KERNELS "suffix_array_kernels.inc"
+#include "symbol_template.h"
+
+// Per thread like the LPF algorithm (see liblpf.c)
+static __thread SAEngine sa_engine = DC3;
+static MergeKind merge_kind = MERGE_PACKED;
+static idx_t sa_small_len = SA_SMALL_LEN, dc3_cutoff = DC3_CUTOFF;
+// Per thread like the phase stats, merge only reads the cycle counter once set_merge_timing enabled it
+static __thread int merge_timing = 0;
+static __thread unsigned long long merge_cycles = 0, merge_elements = 0;
+
+static void dc3(workspace *ws, const text *t, idx_t *sa);
+static size_t dc3_workspace_size(idx_t str_len, idx_t alphabet);
+static int merge_key_bits(idx_t alphabet, idx_t blocks, int *sym_bits, int *rank_bits);
+static idx_t *merge_tuples(workspace *ws, const text *t, tuple_info *tinfo0, tuple_info *tinfo12, idx_t *sa);
+static idx_t *merge_packed(workspace *ws, const text *t, tuple_info *tinfo0, tuple_info *tinfo12, idx_t *sa, int sym_bits, int rank_bits);
+
 // Test cases which were wrongly calculated at first
 // abbbaabbbabbb 
 // babbaabbabaaaaabbabbababbbaabbaabbaabbbbababaaabaaaabaaababbbbbbabbbaabbbbabbaaaabaabaababaaabbabaabababaabbbbbbaabaaabbbbbaaaabaababbbbaabbaaaaaaababababbbbaababbababbbaabbabbaaaabaaabbbabbbabaaabbbaabbbbaaaabaabaababbbabbbbbbabaabbbabaababbabaaaabbbaabbaababbbabaaaabbbaabbaababbabbbbbbaabbbbabaaabbbbaabaaababbbbaaabaaaabaababbbaaaaabbbaabbbaabbbabbbbbbaabbbabbaababaabbbaaabbbbaaa
@@ -21,62 +43,395 @@
 * Given w[1...n], a suffix array SA[1...n] holds the indices i for w[i...n] (all suffixes of w)
 * in lexicographic order. 
 * We can calculate SA in O(n) time using the algorithm described in the above referenced work.
-* The assumption is that w is over the alphabet [1, n]. To ensure this works even for small 
-* input lengths we pad the input with the '\0' character to the length of 127 to cover the ascii alphabet.
-* Additionally we always add '000' to ensure no overflow.
+* The assumption is that w is over the alphabet [0, K). The letters are shifted by one inside
+* the tuples and 0 stands for the positions past the end, so the text needs no padding and
+* the radix sort runs over K+1 buckets.
 * 
-* @param[in] str String over the ascii alphabet for which the suffix array should be calculated.
+* @param[in] t The text (of any symbol width) for which the suffix array should be calculated.
 * 
 * @return Returns a pointer to the suffix array.
 **/
-int *suffix_array(int *str, int str_len) {
-    LOG_MESSAGE("Calculating suffix array for:\n"); 
-    LOG_FUNC(printf_line, str, str_len);
+idx_t *suffix_array(const text *t) {
+    workspace *ws = create_workspace(suffix_array_workspace_size(t));
+    idx_t *sa = mem_alloc(t->len * sizeof(idx_t));
+
+    suffix_array_ws(ws, t, sa);
 
-    // printf("Input string lenght: %d\n", str_len);
-    // printf_line(str, str_len);
+    cleanup_workspace(ws);
+    return sa;
+}
+
+/**
+* @brief Compute the suffix array (DC3) using a workspace for all temporaries.
+*
+* Same as suffix_array but every temporary array of every recursion level
+* is taken from ws and the result is written to sa. A workspace which
+* was already used for an input of the same size is not reallocated.
+*
+* @param[in,out] ws The workspace.
+* @param[in] t The input text.
+* @param[out] sa Output array of size t->len.
+*
+* @return Returns sa.
+**/
+idx_t *suffix_array_ws(workspace *ws, const text *t, idx_t *sa) {
+    if (t->len == 0) {
+        return sa;
+    }
+    ensure_workspace(ws, suffix_array_workspace_size(t));
+    size_t mark = ws_mark(ws);
+    dc3(ws, t, sa);
+    ws_release(ws, mark);
+    return sa;
+}
 
-    tuple_info *tinfo12 = str_to_tuples(str, str_len);
-    tinfo12->tuple_sorting = radix_sort(tinfo12, TUPLE_SIZE);
-    int *tuple_names = name_tuples(tinfo12);
+/**
+* @brief One recursion level of DC3.
+*
+* The arrays are taken from the workspace in the order in which they
+* can be released: the tuple values are gone before the recursion and 
+* the names right after it, so a level holds 4 * 2/3n words while
+* the next level runs. Only the first level reads the text in its own
+* width, the recursion works on the idx_t names.
+**/
+static void dc3(workspace *ws, const text *t, idx_t *sa) {
+    idx_t str_len = t->len;
+    LOG_MESSAGE("Calculating suffix array for:\n"); 
+    LOG_FUNC(print_text, t, 0, str_len, NULL);
+
+    size_t mark = ws_mark(ws);
+    idx_t blocks = tuple_blocks(str_len);
+    tuple_info tinfo12, tinfo0;
+
+    tinfo12.positions = ws_alloc(ws, blocks * sizeof(idx_t));
+    tinfo12.tuple_type = ws_alloc(ws, blocks * sizeof(idx_t));
+    tinfo12.tuple_sorting = ws_alloc(ws, blocks * sizeof(idx_t));
+    size_t level_mark = ws_mark(ws);
+    idx_t *tuple_names = ws_alloc(ws, blocks * sizeof(idx_t));
+    size_t names_mark = ws_mark(ws);
+    tinfo12.values = ws_alloc(ws, blocks * sizeof(*tinfo12.values));
+
+    phase_begin(PHASE_TUPLES);
+    str_to_tuples(&tinfo12, t);
+    phase_end(PHASE_TUPLES);
+    radix_sort(ws, &tinfo12, TUPLE_SIZE);
+    phase_begin(PHASE_NAMING);
+    name_tuples(&tinfo12, tuple_names);
+    phase_end(PHASE_NAMING);
  
-    LOG_FUNC(printf_line, tuple_names, tinfo12->total_blocks);
+    LOG_FUNC(printf_line, tuple_names, tinfo12.total_blocks);
 
     LOG_MESSAGE("T12 info before reordering:\n");
-    LOG_FUNC(print_tuple_info, tinfo12);
+    LOG_FUNC(print_tuple_info, &tinfo12);
+
+    ws_release(ws, names_mark);
+    tinfo12.values = NULL;
  
-    if (tinfo12->max_name != tinfo12->total_blocks) {
-        int *sa12 = suffix_array(tuple_names, tinfo12->total_blocks);
-        free(tinfo12->tuple_sorting);
-        tinfo12->tuple_sorting = sa12;
+    if (tinfo12.max_name != tinfo12.total_blocks) {
+        text names = text_init(tuple_names, tinfo12.total_blocks, SYM_IDX, tinfo12.max_name + 1);
+        phase_begin(PHASE_RECURSION);
+        if (tinfo12.total_blocks > dc3_cutoff || suffix_array_small(&names, tinfo12.tuple_sorting) == NULL) {
+            dc3(ws, &names, tinfo12.tuple_sorting);
+        }
+        phase_end(PHASE_RECURSION);
     }
-    free(tuple_names);
+    ws_release(ws, level_mark);
+
+    reorder(ws, tinfo12.positions, tinfo12.tuple_sorting, tinfo12.total_blocks);
+    reorder(ws, tinfo12.tuple_type, tinfo12.tuple_sorting, tinfo12.total_blocks);
 
-    tinfo12->positions = reorder(tinfo12->positions, tinfo12->tuple_sorting, tinfo12->total_blocks);
-    tinfo12->tuple_type = reorder(tinfo12->tuple_type, tinfo12->tuple_sorting, tinfo12->total_blocks);
+    idx_t blocks0 = (str_len+2)/3;
+    tinfo0.positions = ws_alloc(ws, blocks0 * sizeof(idx_t));
+    tinfo0.values = ws_alloc(ws, blocks0 * sizeof(*tinfo0.values));
+    tinfo0.tuple_sorting = ws_alloc(ws, blocks0 * sizeof(idx_t));
+    tinfo0.tuple_type = NULL;
 
-    tuple_info *tinfo0 = create_t0_ordered(tinfo12, str, str_len);
-    int *sorting0 = counting_sort(tinfo0->values, NULL, str_len > MIN_LEN ? str_len : MIN_LEN, tinfo0->total_blocks, TUPLE_SIZE-1);
-    tinfo0->tuple_sorting = sorting0;
-    tinfo0->positions = reorder(tinfo0->positions, tinfo0->tuple_sorting, tinfo0->total_blocks);
+    phase_begin(PHASE_T0_SORT);
+    create_t0_ordered(&tinfo0, &tinfo12, t);
+    counting_sort(ws, tinfo0.values, NULL, tinfo0.tuple_sorting, tinfo0.key_range, tinfo0.total_blocks, TUPLE_SIZE-1);
+    reorder(ws, tinfo0.positions, tinfo0.tuple_sorting, tinfo0.total_blocks);
+    phase_end(PHASE_T0_SORT);
 
     LOG_MESSAGE("T12 info after reordering:\n");
-    LOG_FUNC(print_tuple_info, tinfo12);
+    LOG_FUNC(print_tuple_info, &tinfo12);
 
-    LOG_FUNC(print_sa_from_tinfo, str, str_len, tinfo12, "SUFFIX ARRAY FOR SA12");
-    LOG_FUNC(print_sa_from_tinfo, str, str_len, tinfo0, "SUFFIX ARRAY FOR SA0");
+    LOG_FUNC(print_sa_from_tinfo, t, &tinfo12, "SUFFIX ARRAY FOR SA12");
+    LOG_FUNC(print_sa_from_tinfo, t, &tinfo0, "SUFFIX ARRAY FOR SA0");
     
-    int *sa = merge(str, str_len, tinfo0, tinfo12);
+    phase_begin(PHASE_MERGE);
+    merge(ws, t, &tinfo0, &tinfo12, sa);
+    phase_end(PHASE_MERGE);
 
     LOG_MESSAGE("Calculated suffix array:\n");
     LOG_FUNC(printf_line, sa, str_len); 
 
-    cleanup_tinfo(tinfo0);
-    cleanup_tinfo(tinfo12);
+    ws_release(ws, mark);
+}
 
+/**
+* @brief Upper bound of the workspace used by suffix_array_ws.
+*
+* Mirrors the allocations of dc3 and assumes that every level recurses.
+*
+* @param[in] t The input text.
+*
+* @return Returns the size in bytes.
+**/
+size_t suffix_array_workspace_size(const text *t) {
+    return dc3_workspace_size(t->len, t->alphabet);
+}
+
+// The names of a level are in [1, blocks] so the next level has blocks+1 letters
+static size_t dc3_workspace_size(idx_t str_len, idx_t alphabet) {
+    idx_t blocks = tuple_blocks(str_len), blocks0 = (str_len+2)/3;
+    size_t level = 3 * WS_SIZE(blocks * sizeof(idx_t));
+    size_t names = WS_SIZE(blocks * sizeof(idx_t));
+    size_t peak, tmp;
+
+    // Radix sort and naming
+    peak = level + names + WS_SIZE(blocks * TUPLE_SIZE * sizeof(idx_t)) + radix_sort_workspace_size(blocks, alphabet + 1);
+
+    // Recursion
+    if (blocks > 1 && blocks < str_len) {
+        tmp = level + names + dc3_workspace_size(blocks, blocks + 1);
+        peak = tmp > peak ? tmp : peak;
+    }
+
+    level += 2 * WS_SIZE(blocks0 * sizeof(idx_t)) + WS_SIZE(blocks0 * TUPLE_SIZE * sizeof(idx_t));
+
+    // Sorting t0 (reorder needs less)
+    tmp = level + counting_sort_workspace_size(alphabet + 1, blocks0);
+    peak = tmp > peak ? tmp : peak;
+
+    // Merge (the packed keys take more space than the letters, if they fit)
+    tmp = level + WS_SIZE((str_len + ADDITIONAL_PADDING) * sizeof(idx_t)) + 2 * WS_SIZE(blocks0 * sizeof(idx_t)) + 2 * WS_SIZE(blocks * sizeof(idx_t));
+    peak = tmp > peak ? tmp : peak;
+    tmp = level + WS_SIZE((str_len + ADDITIONAL_PADDING) * sizeof(idx_t)) + WS_SIZE(2 * blocks0 * sizeof(uint64_t)) + WS_SIZE(blocks * sizeof(uint64_t));
+    peak = tmp > peak ? tmp : peak;
+
+    return peak;
+}
+
+/**
+* @brief Compute the suffix array of a small input by comparing its suffixes.
+*
+* Multikey quicksort over the letters, without any workspace. It has
+* none of the fixed costs of DC3 and SA-IS: no buckets over the alphabet,
+* no radix passes and no recursion levels. It has no linear bound either,
+* the letters read grow with the LCPs (cubic in a periodic text), so it
+* gives up after SMALL_SORT_WORK letters per symbol and the caller runs
+* the engine. Random, Markov and DNA texts take 10 to 60.
+* suffix_array_engine hands it inputs of up to sa_small_len letters and
+* DC3 the reduced problems of up to dc3_cutoff names.
+*
+* @param[in] t The input text.
+* @param[out] sa Output array of size t->len.
+*
+* @return Returns sa, or NULL if the budget ran out (sa is then a permutation).
+**/
+idx_t *suffix_array_small(const text *t, idx_t *sa) {
+    long long budget = (long long)SMALL_SORT_WORK * t->len;
+    for (idx_t i = 0; i < t->len; i++) {
+        sa[i] = i;
+    }
+    TEXT_DISPATCH(t, multikey_sort, t->len, sa, t->len, 0, &budget);
+    return budget >= 0 ? sa : NULL;
+}
+
+/**
+* @brief Compute the suffix array with the selected engine.
+*
+* The engine (DC3 or SA-IS) is set with set_sa_engine, DC3 is the default.
+* Both engines return the same suffix array. Inputs of up to sa_small_len
+* letters are sorted by suffix_array_small instead of either engine.
+*
+* @param[in] t The input text.
+*
+* @return Returns a pointer to the suffix array.
+**/
+idx_t *suffix_array_engine(const text *t) {
+    idx_t *sa;
+
+    phase_begin(PHASE_SA);
+    if (t->len <= sa_small_len) {
+        sa = mem_alloc(t->len * sizeof(idx_t));
+        if (suffix_array_small(t, sa) != NULL) {
+            phase_end(PHASE_SA);
+            return sa;
+        }
+        mem_free(sa, t->len * sizeof(idx_t));
+    }
+    switch (sa_engine) {
+        case SAIS:
+            sa = suffix_array_sais(t);
+            break;
+        case DC3:
+        default:
+            sa = suffix_array(t);
+            break;
+    }
+    phase_end(PHASE_SA);
     return sa;
 }
 
+/**
+* @brief Compute the suffix array with the selected engine and time its phases.
+*
+* The phase timers (phase.h) are on during the call, stats receives
+* the time of every DC3 or SA-IS step and of every recursion level.
+*
+* @param[in] t The input text.
+* @param[out] stats The phases of the call.
+*
+* @return Returns a pointer to the suffix array.
+**/
+idx_t *suffix_array_profile(const text *t, phase_stats *stats) {
+    int timing = get_phase_timing();
+    set_phase_timing(1);
+    reset_phase_stats();
+
+    idx_t *sa = suffix_array_engine(t);
+
+    get_phase_stats(stats);
+    set_phase_timing(timing);
+    return sa;
+}
+
+idx_t *suffix_array_engine_ws(workspace *ws, const text *t, idx_t *sa) {
+    if (t->len <= sa_small_len && suffix_array_small(t, sa) != NULL) {
+        return sa;
+    }
+    switch (sa_engine) {
+        case SAIS:
+            return suffix_array_sais_ws(ws, t, sa);
+        case DC3:
+        default:
+            return suffix_array_ws(ws, t, sa);
+    }
+}
+
+size_t suffix_array_engine_workspace_size(const text *t) {
+    switch (sa_engine) {
+        case SAIS:
+            return suffix_array_sais_workspace_size(t);
+        case DC3:
+        default:
+            return suffix_array_workspace_size(t);
+    }
+}
+
+void set_sa_engine(SAEngine engine) {
+    sa_engine = engine;
+}
+
+SAEngine get_sa_engine() {
+    return sa_engine;
+}
+
+/**
+* @brief Largest input which suffix_array_engine sorts with suffix_array_small.
+*
+* 0 always runs the engine. The default SA_SMALL_LEN comes from the
+* timings in the README, --small tunes it for another machine.
+**/
+void set_sa_small_len(idx_t len) {
+    sa_small_len = len < 0 ? 0 : len;
+}
+
+idx_t get_sa_small_len() {
+    return sa_small_len;
+}
+
+/**
+* @brief Largest reduced problem of DC3 which is sorted with suffix_array_small.
+*
+* Below it a recursion level costs more in fixed overhead than the
+* comparisons of its names. 0 recurses down to unique names.
+**/
+void set_dc3_cutoff(idx_t blocks) {
+    dc3_cutoff = blocks < 0 ? 0 : blocks;
+}
+
+idx_t get_dc3_cutoff() {
+    return dc3_cutoff;
+}
+
+void set_merge_kind(MergeKind kind) {
+    merge_kind = kind;
+}
+
+MergeKind get_merge_kind() {
+    return merge_kind;
+}
+
+/**
+* @brief Count the cycles and suffixes of every merge of the calling thread.
+**/
+void set_merge_timing(int enabled) {
+    merge_timing = enabled;
+}
+
+int get_merge_timing() {
+    return merge_timing;
+}
+
+/**
+* @brief Cycles spent in merge and suffixes merged by the calling thread since
+* the last reset_merge_stats, 0 unless set_merge_timing enabled them.
+**/
+void merge_stats(unsigned long long *cycles, unsigned long long *elements) {
+    *cycles = merge_cycles;
+    *elements = merge_elements;
+}
+
+void reset_merge_stats() {
+    merge_cycles = 0;
+    merge_elements = 0;
+}
+
+const char *sa_engine_name(SAEngine engine) {
+    switch (engine) {
+        case SAIS:
+            return "sais";
+        case DC3:
+        default:
+            return "dc3";
+    }
+}
+
+/**
+* @brief Parse the engine name ("dc3" or "sais").
+*
+* @return Returns 1 if the name was recognized, 0 otherwise.
+**/
+int parse_sa_engine(const char *name, SAEngine *engine) {
+    if (!strcmp(name, "dc3")) {
+        *engine = DC3;
+        return 1;
+    }
+    if (!strcmp(name, "sais")) {
+        *engine = SAIS;
+        return 1;
+    }
+    return 0;
+}
+
+const char *merge_kind_name(MergeKind kind) {
+    return kind == MERGE_TUPLES ? "tuples" : "packed";
+}
+
+int parse_merge_kind(const char *name, MergeKind *kind) {
+    if (!strcmp(name, "packed")) {
+        *kind = MERGE_PACKED;
+        return 1;
+    }
+    if (!strcmp(name, "tuples")) {
+        *kind = MERGE_TUPLES;
+        return 1;
+    }
+    return 0;
+}
+
 /**
 * @brief Merge the array of suffixes mod 0 and the array of suffixes mod 1, mod 2.
 *
@@ -84,47 +439,123 @@ int *suffix_array(int *str, int str_len) {
 * Notice that the algorithm assumes that the positions in tinfo0 and tinfo12
 * are already sorted.
 *
-* @param[in] str The input string.
-* @param[in] str_len The length of the input string.
+* The comparisons use packed 64-bit keys (merge_packed) if the letters
+* and ranks of the level fit, the tuples otherwise or if set_merge_kind
+* selected them. With set_merge_timing the cycles spent are added to the
+* merge statistics of the calling thread.
+*
+* @param[in,out] ws Workspace for the temporary arrays.
+* @param[in] t The input text.
 * @param[in] tinfo0 Tuple info mod 3 = 0.
 * @param[in] tinfo12 Tuple infor mod 3 = 1,2.
+* @param[out] sa Output array of size str_len.
 *
 * @return Returns the merged suffix array of SA0 and SA12.
 **/
-int *merge(int *str, int str_len, tuple_info *tinfo0, tuple_info *tinfo12) {
+idx_t *merge(workspace *ws, const text *t, tuple_info *tinfo0, tuple_info *tinfo12, idx_t *sa) {
+    uint64_t start = merge_timing ? cycle_count() : 0;
+    int sym_bits, rank_bits;
+
+    if (merge_kind == MERGE_PACKED && merge_key_bits(t->alphabet, tinfo12->total_blocks, &sym_bits, &rank_bits)) {
+        merge_packed(ws, t, tinfo0, tinfo12, sa, sym_bits, rank_bits);
+    } else {
+        merge_tuples(ws, t, tinfo0, tinfo12, sa);
+    }
+
+    if (merge_timing) {
+        merge_cycles += cycle_count() - start;
+        merge_elements += t->len;
+    }
+    return sa;
+}
+
+// Bits of the letters (shifted by one) and of the ranks, 0 if a 3-part key does not fit into 63 bits
+static int merge_key_bits(idx_t alphabet, idx_t blocks, int *sym_bits, int *rank_bits) {
+    *sym_bits = 64 - __builtin_clzll((unsigned long long)alphabet | 1);
+    *rank_bits = 64 - __builtin_clzll((unsigned long long)blocks | 1);
+    return 2 * *sym_bits + *rank_bits <= 63;
+}
+
+/**
+* @brief Merge with precomputed packed keys and no branches in the loop.
+*
+* A comparison of DC3 is (letter, rank) against a suffix mod 1 and
+* (letter, letter, rank) against a suffix mod 2. Both forms are packed
+* into one 64-bit key for every suffix mod 0 and the matching form for
+* every suffix mod 1/2, with its form in bit 63. A step loads the key
+* of the mod 0 suffix selected by that bit, does one comparison and
+* advances one of the two sides without a branch.
+**/
+static idx_t *merge_packed(workspace *ws, const text *t, tuple_info *tinfo0, tuple_info *tinfo12, idx_t *sa, int sym_bits, int rank_bits) {
+    idx_t str_len = t->len;
+    idx_t n0 = tinfo0->total_blocks, n12 = tinfo12->total_blocks;
+    size_t mark = ws_mark(ws);
+
+    uint64_t *keys0 = ws_alloc(ws, 2 * (size_t)n0 * sizeof(uint64_t));
+    uint64_t *keys12 = ws_alloc(ws, (size_t)n12 * sizeof(uint64_t));
+    idx_t *sa12r = _reverse_suffix_array(ws, tinfo12->positions, n12, str_len+ADDITIONAL_PADDING);
+    TEXT_DISPATCH(t, merge_keys, str_len, sa12r, tinfo0, tinfo12, keys0, keys12, sym_bits, rank_bits);
+
+    const idx_t *pos0 = tinfo0->positions, *pos12 = tinfo12->positions;
+    const uint64_t mask = ~(1ULL << 63);
+    idx_t i0 = 0, i12 = str_len % 3 == 1, k = 0;
+
+    while (i0 < n0 && i12 < n12) {
+        uint64_t key12 = keys12[i12];
+        idx_t take0 = keys0[2*i0 + (key12 >> 63)] <= (key12 & mask);
+        idx_t p0 = pos0[i0], p12 = pos12[i12];
+        sa[k++] = p12 ^ ((p0 ^ p12) & -take0);
+        i0 += take0;
+        i12 += 1 - take0;
+    }
+    while (i12 < n12) {
+        sa[k++] = pos12[i12++];
+    }
+    while (i0 < n0) {
+        sa[k++] = pos0[i0++];
+    }
+
+    ws_release(ws, mark);
+    return sa;
+}
+
+/**
+* @brief Merge comparing the tuples letter by letter.
+*
+* The reference for merge_packed, used when the packed keys do not fit.
+**/
+static idx_t *merge_tuples(workspace *ws, const text *t, tuple_info *tinfo0, tuple_info *tinfo12, idx_t *sa) {
     LOG_MESSAGE("Merging\n");
-    int extra_block = str_len % 3 == 1;
+    idx_t str_len = t->len;
+    idx_t extra_block = str_len % 3 == 1;
+    size_t mark = ws_mark(ws);
 
-    int *sa12r = _reverse_suffix_array(tinfo12->positions, tinfo12->total_blocks,str_len+ADDITIONAL_PADDING);
+    idx_t *sa12r = _reverse_suffix_array(ws, tinfo12->positions, tinfo12->total_blocks,str_len+ADDITIONAL_PADDING);
     // to_bign(sa12r, str_len+ADDITIONAL_PADDING);
 
-    int *str0 = _create_str(str, tinfo0->positions, tinfo0->total_blocks, 0);
-    int *str10 = _create_str(str, tinfo0->positions, tinfo0->total_blocks, 1);
-    int *str12 = _create_str(str, tinfo12->positions, tinfo12->total_blocks, 0);
-    int *str012 = _create_str(str, tinfo12->positions, tinfo12->total_blocks, 1);
+    idx_t *str0 = _create_str(ws, t, tinfo0->positions, tinfo0->total_blocks, 0);
+    idx_t *str10 = _create_str(ws, t, tinfo0->positions, tinfo0->total_blocks, 1);
+    idx_t *str12 = _create_str(ws, t, tinfo12->positions, tinfo12->total_blocks, 0);
+    idx_t *str012 = _create_str(ws, t, tinfo12->positions, tinfo12->total_blocks, 1);
 
-    int *sa = malloc(sizeof(int) * str_len);
-    int cr, pos_12, pos_0; // Hold the comparison, positions in SA_12/SA_0
-    int i0 = 0, i12 = extra_block; // Counts position in sa_12, sa_0
-    int k = 0;
+    idx_t cr, pos_12, pos_0; // Hold the comparison, positions in SA_12/SA_0
+    idx_t i0 = 0, i12 = extra_block; // Counts position in sa_12, sa_0
+    idx_t k = 0;
 
-    int *m02 = malloc(2 * sizeof(int));
-    int *m12 = malloc(2 * sizeof(int));
-
-    int *m03 = malloc(3 * sizeof(int));
-    int *m23 = malloc(3 * sizeof(int));
+    idx_t m02[2], m12[2];
+    idx_t m03[3], m23[3];
 
     while(i0 < tinfo0->total_blocks && i12 < tinfo12->total_blocks) {
-        LOG_MESSAGE("\n------------------------ i : %d, j : %d\n", i12, i0);
+        LOG_MESSAGE("\n------------------------ i : %" PRIdx ", j : %" PRIdx "\n", i12, i0);
 
         pos_12 = tinfo12->positions[i12];
         pos_0  = tinfo0->positions[i0];
 
         LOG_MESSAGE("Comparing: \n");
-        LOG_MESSAGE("%d: ", pos_0);
-        LOG_FUNC(printf_line, str+pos_0, str_len-pos_0);
-        LOG_MESSAGE("%d: ", pos_12);
-        LOG_FUNC(printf_line, str+pos_12, str_len-pos_12);
+        LOG_MESSAGE("%" PRIdx ": ", pos_0);
+        LOG_FUNC(print_text, t, pos_0, str_len-pos_0, NULL);
+        LOG_MESSAGE("%" PRIdx ": ", pos_12);
+        LOG_FUNC(print_text, t, pos_12, str_len-pos_12, NULL);
         LOG_MESSAGE("\n");
  
         if (tinfo12->tuple_type[i12] == 1) {
@@ -135,9 +566,9 @@ int *merge(int *str, int str_len, tuple_info *tinfo0, tuple_info *tinfo12) {
             m12[0] = str12[i12];
             m12[1] = sa12r[pos_12+1]; // We are safe from overflowing because sa_rev has -1 at the end
 
-            LOG_MESSAGE("m0: (%d, %d) vs m12: (%d, %d)\n", m02[0], m02[1], m12[0], m12[1]);
+            LOG_MESSAGE("m0: (%" PRIdx ", %" PRIdx ") vs m12: (%" PRIdx ", %" PRIdx ")\n", m02[0], m02[1], m12[0], m12[1]);
             cr = compare_tuples(m02, m12, 2);
-            // cr = memcmp(m02, m12, 2 * sizeof(int));
+            // cr = memcmp(m02, m12, 2 * sizeof(idx_t));
         } 
         else {
             LOG_MESSAGE("Case 2\n");
@@ -149,16 +580,16 @@ int *merge(int *str, int str_len, tuple_info *tinfo0, tuple_info *tinfo12) {
             m23[1] = str012[i12];
             m23[2] = sa12r[pos_12+2];
             
-            LOG_MESSAGE("m0: (%d, %d, %d) vs m12: (%d, %d, %d)\n", m03[0], m03[1], m03[2], m23[0], m23[1], m23[2]);
+            LOG_MESSAGE("m0: (%" PRIdx ", %" PRIdx ", %" PRIdx ") vs m12: (%" PRIdx ", %" PRIdx ", %" PRIdx ")\n", m03[0], m03[1], m03[2], m23[0], m23[1], m23[2]);
             cr = compare_tuples(m03, m23, 3);
-            // cr = memcmp(m03, m23, 3 * sizeof(int));
+            // cr = memcmp(m03, m23, 3 * sizeof(idx_t));
         }
         if (cr <= 0) {
-            LOG_MESSAGE("%d won\n", pos_0);
+            LOG_MESSAGE("%" PRIdx " won\n", pos_0);
             sa[k++] = pos_0;
             i0 += 1;
         } else {
-            LOG_MESSAGE("%d won\n", pos_12);
+            LOG_MESSAGE("%" PRIdx " won\n", pos_12);
             sa[k++] = pos_12;
             i12 += 1;
         }
@@ -171,33 +602,24 @@ int *merge(int *str, int str_len, tuple_info *tinfo0, tuple_info *tinfo12) {
         sa[k++] = tinfo0->positions[i0++];
     }
 
-    free(sa12r);
-
-    free(m02);
-    free(m12);
-    free(m03);
-    free(m23);
-
-    free(str0);
-    free(str10);
-    free(str12);
-    free(str012);
-
+    ws_release(ws, mark);
     return sa;
 }
 
 /**
-* @brief Reorder the input array according to a sorted-indices array.
+* @brief Reorder the input array (in place) according to a sorted-indices array.
 *
 * @return Returns a pointer to the sorted array.
 **/
-int *reorder(int *arr, int *sorting, int len) {
-    int *reorder = malloc(len * sizeof(int));
-    for (int i = 0; i < len; i++) {
+idx_t *reorder(workspace *ws, idx_t *arr, idx_t *sorting, idx_t len) {
+    size_t mark = ws_mark(ws);
+    idx_t *reorder = ws_alloc(ws, len * sizeof(idx_t));
+    for (idx_t i = 0; i < len; i++) {
         reorder[i] = arr[sorting[i]];
     }
-    free(arr);
-    return reorder;
+    memcpy(arr, reorder, len * sizeof(idx_t));
+    ws_release(ws, mark);
+    return arr;
 }
 
 /**
@@ -207,16 +629,13 @@ int *reorder(int *arr, int *sorting, int len) {
 * the values which are needed to create pairs and triplets to
 * compare in the merge part of the algorithm.
 * The resulting array can be walked index by index instead of 
-* random jumps. 
+* random jumps. The letters are shifted like the tuple values.
 *
 * @return Returns a pointer to a sorted array.
 **/
-int *_create_str(int *str, int *positions, int len, int a) {
-    int *str0 = malloc(len * sizeof(int));
-    for (int i=0; i < len; i++) {
-        str0[i] = str[positions[i] + a];
-
-    }
+idx_t *_create_str(workspace *ws, const text *t, idx_t *positions, idx_t len, idx_t a) {
+    idx_t *str0 = ws_alloc(ws, len * sizeof(idx_t));
+    TEXT_DISPATCH(t, create_str, t->len, str0, positions, len, a);
     return str0;
 }
 
@@ -231,21 +650,20 @@ int *_create_str(int *str, int *positions, int len, int a) {
 *
 * @return Returns the reversed suffix array + 1.
 **/
-int *_reverse_suffix_array(int *positions, int pos_len, int out_len) {
+idx_t *_reverse_suffix_array(workspace *ws, idx_t *positions, idx_t pos_len, idx_t out_len) {
     LOG_MESSAGE("Reversing suffix array\n");
-    int *sar = calloc(out_len, sizeof(int));
-    for (int i = 0; i < pos_len; i++) {
+    idx_t *sar = ws_calloc(ws, out_len * sizeof(idx_t));
+    for (idx_t i = 0; i < pos_len; i++) {
         sar[positions[i]] = i+1;
     }
     LOG_MESSAGE("Reversing successful\n");
     return sar;
 }
 
-void print_suffix_array(int *str, int *sa, int len) {
-    for (int i = 0; i < len; i++) {
-        int pos = sa[i];
-        printf("SA[%d] = %d\t", i, pos);
-        fwrite(str + pos,  sizeof(int), len - pos,stdout);
-        printf("\n");
+void print_suffix_array(const text *t, idx_t *sa) {
+    for (idx_t i = 0; i < t->len; i++) {
+        idx_t pos = sa[i];
+        printf("SA[%" PRIdx "] = %" PRIdx "\t", i, pos);
+        print_text(t, pos, t->len - pos, NULL);
     }
 }
@@ -1,16 +1,41 @@
 #include "constants.h"
+#include "workspace.h"
+#include "text.h"
+#include "phase.h"
 
 #ifndef SUFFIX_ARRAY_H
 #define SUFFIX_ARRAY_H
 
-int *suffix_array(int *str, int str_len);
-int *_reverse_suffix_array(int *positions, int pos_len, int out_len) ;
+idx_t *suffix_array(const text *t);
+idx_t *suffix_array_ws(workspace *ws, const text *t, idx_t *sa);
+size_t suffix_array_workspace_size(const text *t);
+idx_t *suffix_array_small(const text *t, idx_t *sa);
+idx_t *suffix_array_engine(const text *t);
+idx_t *suffix_array_profile(const text *t, phase_stats *stats);
+idx_t *suffix_array_engine_ws(workspace *ws, const text *t, idx_t *sa);
+size_t suffix_array_engine_workspace_size(const text *t);
+void set_sa_engine(SAEngine engine);
+SAEngine get_sa_engine();
+void set_sa_small_len(idx_t len);
+idx_t get_sa_small_len();
+void set_dc3_cutoff(idx_t blocks);
+idx_t get_dc3_cutoff();
+const char *sa_engine_name(SAEngine engine);
+int parse_sa_engine(const char *name, SAEngine *engine);
+void set_merge_kind(MergeKind kind);
+MergeKind get_merge_kind();
+const char *merge_kind_name(MergeKind kind);
+int parse_merge_kind(const char *name, MergeKind *kind);
+void set_merge_timing(int enabled);
+int get_merge_timing();
+void merge_stats(unsigned long long *cycles, unsigned long long *elements);
+void reset_merge_stats();
+idx_t *_reverse_suffix_array(workspace *ws, idx_t *positions, idx_t pos_len, idx_t out_len);
 
-int *merge(int *str, int str_len, tuple_info *tinfo0, tuple_info *tinfo12);
-int *reorder(int *arr, int *sorting, int len);
-int *_create_str(int *str, int *positions, int len, int a);
+idx_t *merge(workspace *ws, const text *t, tuple_info *tinfo0, tuple_info *tinfo12, idx_t *sa);
+idx_t *reorder(workspace *ws, idx_t *arr, idx_t *sorting, idx_t len);
+idx_t *_create_str(workspace *ws, const text *t, idx_t *positions, idx_t len, idx_t a);
 
-void print_suffix(int *str, int str_len, int pos);
-void print_suffix_array(int *str, int *sa, int len);
+void print_suffix_array(const text *t, idx_t *sa);
 
 #endif
\ No newline at end of file
@@ -1,29 +1,30 @@
+#include "text.h"
+#include "constants.h"
+#include "workspace.h"
+#include "suffix_array_qsort.h"
+
 #include <stdlib.h>
 
-int **str_ptr;
-int *str_len_ptr;
+const text *text_ptr;
 
 int compare(const void *a, const void *b) {
-    int pos1 = *(int*)a, pos2 = *(int*)b;
-    int alen = *str_len_ptr - pos1, blen = *str_len_ptr - pos2;
-    int bound = alen > blen ? blen : alen;
-    int *str = *str_ptr;
+    idx_t pos1 = *(idx_t*)a, pos2 = *(idx_t*)b;
+    idx_t alen = text_ptr->len - pos1, blen = text_ptr->len - pos2;
+    idx_t bound = alen > blen ? blen : alen;
 
-    for(int i = 0; i < bound; i++) {
-        if (str[pos1+i] != str[pos2+i]) {
-            return str[pos1+i] - str[pos2+i];
-        } 
+    idx_t i = text_match(text_ptr, pos1, pos2, bound);
+    if (i < bound) {
+        return text_symbol(text_ptr, pos1+i) < text_symbol(text_ptr, pos2+i) ? -1 : 1;
     }
-    return alen - blen;
+    return (alen > blen) - (alen < blen);
 }
 
-int *suffix_array_qsort(int *str, int str_len) {
-    int *sa = malloc(sizeof(int) * str_len);
-    for (int i = 0; i < str_len; i++) {
+idx_t *suffix_array_qsort(const text *t) {
+    idx_t *sa = mem_alloc(t->len * sizeof(idx_t));
+    for (idx_t i = 0; i < t->len; i++) {
         sa[i] = i;
     }
-    str_ptr = &str;
-    str_len_ptr = &str_len;
-    qsort(sa, str_len, sizeof(int), compare);
+    text_ptr = t;
+    qsort(sa, t->len, sizeof(idx_t), compare);
     return sa;
-}
\ No newline at end of file
+}
@@ -1,7 +1,10 @@
+#include "constants.h"
+#include "text.h"
+
 #ifndef SUFFIX_ARRAY_QSORT_H
 #define SUFFIX_ARRAY_QSORT_H
 
 int compare(const void *a, const void *b);
-int *suffix_array_qsort(int *str, int str_len);
+idx_t *suffix_array_qsort(const text *t);
 
 #endif
\ No newline at end of file
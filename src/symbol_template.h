@@ -0,0 +1,38 @@
+/*
+* Instantiates the kernel template named by SYMBOL_KERNELS once per symbol
+* type. Inside the template SYM_T is the symbol type and SYM(name) appends
+* the matching suffix (_u8, _u16, _u32, _idx) which TEXT_DISPATCH expects.
+*
+* Usage:
+*   #define SYMBOL_KERNELS "lcp_kernels.inc"
+*   #include "symbol_template.h"
+*
+* There is no include guard, the file is included once per template.
+*/
+#include "text.h"
+
+#define SYM_T uint8_t
+#define SYM(name) name##_u8
+#include SYMBOL_KERNELS
+#undef SYM_T
+#undef SYM
+
+#define SYM_T uint16_t
+#define SYM(name) name##_u16
+#include SYMBOL_KERNELS
+#undef SYM_T
+#undef SYM
+
+#define SYM_T uint32_t
+#define SYM(name) name##_u32
+#include SYMBOL_KERNELS
+#undef SYM_T
+#undef SYM
+
+#define SYM_T idx_t
+#define SYM(name) name##_idx
+#include SYMBOL_KERNELS
+#undef SYM_T
+#undef SYM
+
+#undef SYMBOL_KERNELS
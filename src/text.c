@@ -0,0 +1,116 @@
+#include "text.h"
+#include "mismatch.h"
+#include "constants.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+/**
+* @brief Describe a text without copying it.
+*
+* The symbols are read in their own width by every kernel, byte input
+* is never widened to idx_t. Since the suffix array algorithms shift
+* the symbols by one (0 marks the end of the text) the alphabet has
+* to stay below IDX_MAX.
+*
+* @param[in] symbols The symbols (not padded).
+* @param[in] len Number of symbols.
+* @param[in] type Width of the symbols.
+* @param[in] alphabet Upper bound of the symbols (exclusive), 0 to scan the text for it.
+*
+* @return Returns the text descriptor.
+**/
+text text_init(const void *symbols, idx_t len, SymbolType type, idx_t alphabet) {
+    text t = {symbols, len, alphabet, type};
+
+    if (alphabet <= 0) {
+        long long max = -1;
+        for (idx_t i = 0; i < len; i++) {
+            long long sym = type == SYM_U32 ? (long long)((const uint32_t *)symbols)[i] : (long long)text_symbol(&t, i);
+            max = sym > max ? sym : max;
+        }
+        if (max + 1 >= IDX_MAX) {
+            fprintf(stderr, "Symbol %lld does not fit into %d-bit indices, compact the alphabet (compact_alphabet)\n", max, INDEX_BITS);
+            exit(1);
+        }
+        t.alphabet = (idx_t)(max + 1);
+    }
+    if (t.alphabet >= IDX_MAX) {
+        fprintf(stderr, "Alphabet of size %" PRIdx " does not fit into %d-bit indices\n", t.alphabet, INDEX_BITS);
+        exit(1);
+    }
+    return t;
+}
+
+/**
+* @brief Read a single symbol of any width.
+*
+* Meant for printing and the naive validation algorithms, the kernels
+* read the typed symbols directly.
+**/
+idx_t text_symbol(const text *t, idx_t i) {
+    switch (t->type) {
+        case SYM_U8:
+            return ((const uint8_t *)t->symbols)[i];
+        case SYM_U16:
+            return ((const uint16_t *)t->symbols)[i];
+        case SYM_U32:
+            return (idx_t)((const uint32_t *)t->symbols)[i];
+        case SYM_IDX:
+        default:
+            return ((const idx_t *)t->symbols)[i];
+    }
+}
+
+/**
+* @brief Number of equal symbols of the suffixes i and j, at most max.
+*
+* Used by the naive validation algorithms, compares many symbols per
+* step (see common_prefix).
+**/
+idx_t text_match(const text *t, idx_t i, idx_t j, idx_t max) {
+    size_t width = symbol_size(t->type);
+    const char *symbols = t->symbols;
+    return common_prefix(symbols + (size_t)i * width, symbols + (size_t)j * width, max, width);
+}
+
+size_t symbol_size(SymbolType type) {
+    switch (type) {
+        case SYM_U8:
+            return sizeof(uint8_t);
+        case SYM_U16:
+            return sizeof(uint16_t);
+        case SYM_U32:
+            return sizeof(uint32_t);
+        case SYM_IDX:
+        default:
+            return sizeof(idx_t);
+    }
+}
+
+/**
+* @brief The narrowest symbol type which holds the letters [0, alphabet).
+**/
+SymbolType symbol_type_for(idx_t alphabet) {
+    if (alphabet <= 1 << 8) {
+        return SYM_U8;
+    }
+    if (alphabet <= 1 << 16) {
+        return SYM_U16;
+    }
+    return SYM_U32;
+}
+
+const char *symbol_type_name(SymbolType type) {
+    switch (type) {
+        case SYM_U8:
+            return "u8";
+        case SYM_U16:
+            return "u16";
+        case SYM_U32:
+            return "u32";
+        case SYM_IDX:
+        default:
+            return "idx";
+    }
+}
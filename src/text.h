@@ -0,0 +1,56 @@
+#include "constants.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TEXT_H
+#define TEXT_H
+
+// SymbolType, text and text_init are part of the library interface (liblpf.h)
+idx_t text_symbol(const text *t, idx_t i);
+idx_t text_match(const text *t, idx_t i, idx_t j, idx_t max);
+size_t symbol_size(SymbolType type);
+SymbolType symbol_type_for(idx_t alphabet);
+const char *symbol_type_name(SymbolType type);
+
+// The symbols of any width as unsigned values, idx_t symbols are never negative
+static inline uint64_t raw_symbol(const void *symbols, SymbolType type, idx_t i) {
+    switch (type) {
+        case SYM_U8:
+            return ((const uint8_t *)symbols)[i];
+        case SYM_U16:
+            return ((const uint16_t *)symbols)[i];
+        case SYM_U32:
+            return ((const uint32_t *)symbols)[i];
+        case SYM_IDX:
+        default:
+            return (uint64_t)((const idx_t *)symbols)[i];
+    }
+}
+
+/**
+* Run the kernel name_u8, name_u16, name_u32 or name_idx matching the
+* symbol type of t. The kernel gets the typed symbols followed by the
+* remaining arguments. Kernels are written once as a template (*.inc)
+* and instantiated with symbol_template.h.
+**/
+#define TEXT_DISPATCH(t, name, ...) \
+    do { \
+        switch ((t)->type) { \
+            case SYM_U8: \
+                name##_u8((const uint8_t *)(t)->symbols, __VA_ARGS__); \
+                break; \
+            case SYM_U16: \
+                name##_u16((const uint16_t *)(t)->symbols, __VA_ARGS__); \
+                break; \
+            case SYM_U32: \
+                name##_u32((const uint32_t *)(t)->symbols, __VA_ARGS__); \
+                break; \
+            case SYM_IDX: \
+            default: \
+                name##_idx((const idx_t *)(t)->symbols, __VA_ARGS__); \
+                break; \
+        } \
+    } while (0)
+
+#endif
@@ -1,10 +1,52 @@
 #include "tuple.h"
+#include "text.h"
+#include "parallel.h"
 #include "constants.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
+#define SYMBOL_KERNELS "tuple_kernels.inc"
+#include "symbol_template.h"
+
+struct naming_job {
+    tuple_info *tinfo;
+    idx_t *tuple_names;
+    idx_t names[MAX_THREADS];
+};
+typedef struct naming_job naming_job;
+
+static inline idx_t new_name(tuple_info *tinfo, idx_t i) {
+    idx_t *sorting = tinfo->tuple_sorting;
+    return i > 0 && memcmp(tinfo->values[sorting[i-1]], tinfo->values[sorting[i]], TUPLE_SIZE * sizeof(idx_t)) != 0;
+}
+
+// Counts the distinct tuple boundaries inside the chunk
+static void count_names_task(void *arg, int id, int chunks) {
+    naming_job *job = arg;
+    idx_t end = chunk_begin(job->tinfo->total_blocks, id+1, chunks);
+    idx_t names = 0;
+
+    for (idx_t i = chunk_begin(job->tinfo->total_blocks, id, chunks); i < end; i++) {
+        names += new_name(job->tinfo, i);
+    }
+    job->names[id] = names;
+}
+
+// Assigns names starting with the first name of the chunk
+static void assign_names_task(void *arg, int id, int chunks) {
+    naming_job *job = arg;
+    idx_t *sorting = job->tinfo->tuple_sorting;
+    idx_t end = chunk_begin(job->tinfo->total_blocks, id+1, chunks);
+    idx_t name = job->names[id];
+
+    for (idx_t i = chunk_begin(job->tinfo->total_blocks, id, chunks); i < end; i++) {
+        name += new_name(job->tinfo, i);
+        job->tuple_names[sorting[i]] = name;
+    }
+}
+
 /**
 * @brief Assign to the input tuples a new letter from the alphabet.
 *
@@ -14,30 +56,49 @@
 * range [1, 2/3n]
 *
 * @param[in] tinfo Information about the tuples (must be sorted)
+* @param[out] tuple_names Output array of size total_blocks.
 *
 * @return Returns a pointer to an array with new names corresponding to tuples in str.
 **/
-int *name_tuples(tuple_info *tinfo) {
-    int *tuple_names = malloc(sizeof(int) * (tinfo->total_blocks + ADDITIONAL_PADDING));
-    int *sorting = tinfo->tuple_sorting; 
-    tuple_names[sorting[0]] = 1;
-
-    int name = 1;
-    for (int i = 1; i < tinfo->total_blocks; i++) {
-        // int cmp = compare_tuples(tinfo->values[sorting[i-1]], tinfo->values[sorting[i]], TUPLE_SIZE);
-        int cmp = memcmp(tinfo->values[sorting[i-1]], tinfo->values[sorting[i]], TUPLE_SIZE * sizeof(int));
-        if (cmp != 0) {
-            name++;
+idx_t *name_tuples(tuple_info *tinfo, idx_t *tuple_names) {
+    int chunks = parallel_chunks(tinfo->total_blocks);
+    naming_job job;
+    job.tinfo = tinfo;
+    job.tuple_names = tuple_names;
+
+    // With more chunks the names are assigned by a parallel scan: 
+    // count the boundaries per chunk, prefix sum, assign.
+    job.names[0] = 1;
+    if (chunks > 1) {
+        parallel_run(count_names_task, &job, chunks);
+        idx_t name = 1;
+        for (int t = 0; t < chunks; t++) {
+            idx_t tmp = job.names[t];
+            job.names[t] = name;
+            name += tmp;
         }
-        tuple_names[sorting[i]] = name;
     }
-    for (int i = tinfo->total_blocks; i < tinfo->total_blocks + ADDITIONAL_PADDING; i++) {
-        tuple_names[i] = 0;
-    }
-    tinfo->max_name = name;
+    parallel_run(assign_names_task, &job, chunks);
+
+    tinfo->max_name = tuple_names[tinfo->tuple_sorting[tinfo->total_blocks-1]];
     return tuple_names;
 }
 
+struct tuple_job {
+    tuple_info *tinfo;
+    const text *t;
+    idx_t type1_blocks;
+};
+typedef struct tuple_job tuple_job;
+
+static void fill_tuples_task(void *arg, int id, int chunks) {
+    tuple_job *job = arg;
+    idx_t begin = chunk_begin(job->tinfo->total_blocks, id, chunks);
+    idx_t end = chunk_begin(job->tinfo->total_blocks, id+1, chunks);
+
+    TEXT_DISPATCH(job->t, fill_tuples, job->tinfo, job->t->len, job->type1_blocks, begin, end);
+}
+
 /**
 * @brief Creates the tuple info structure for str.
 *
@@ -48,46 +109,62 @@ int *name_tuples(tuple_info *tinfo) {
 * later is extended to hold information about the sorting
 * and naming of the tuples. 
 *
-* @param[in] str The input string.
-* @param[in] str_len String length.
+* The values are the letters + 1, positions past the end of
+* the text get 0 so the text does not need any padding.
+*
+* @param[in,out] tinfo The positions, tuple_type and values arrays must hold tuple_blocks(t->len) entries.
+* @param[in] t The input text.
 *
 **/
-tuple_info *str_to_tuples(int *str, int str_len) {
+tuple_info *str_to_tuples(tuple_info *tinfo, const text *t) {
     LOG_MESSAGE("Creating new tuples\n");
-    tuple_info *tinfo = malloc(sizeof(tuple_info));
-    int extra_block = str_len % 3 == 1;
-    tinfo->total_blocks = (str_len - (str_len + 2)/3) + extra_block;
-
-    tinfo->positions = malloc(tinfo->total_blocks * sizeof(int));   
-    tinfo->tuple_type = malloc(tinfo->total_blocks * sizeof(int));
-    tinfo->values = malloc(tinfo->total_blocks * sizeof(*tinfo->values));
-    tinfo->tuple_sorting = NULL;
-
-    int k = 0, i = 1;
-    while(i < str_len + extra_block) {
-        tinfo->positions[k] = i;
-        tinfo->tuple_type[k] = 1;
-        for (int q = 0; q < TUPLE_SIZE; q++) {
-            tinfo->values[k][q] = str[i+q];
-        }
-        k++;
-        i += 3;
-    }
+    idx_t extra_block = t->len % 3 == 1;
+    tinfo->total_blocks = tuple_blocks(t->len);
+    tinfo->key_range = t->alphabet + 1;
 
-    i = 2;
-    while(i < str_len) {
-        tinfo->positions[k] = i;
-        tinfo->tuple_type[k] = 2;
-        for (int q = 0; q < TUPLE_SIZE; q++) {
-            tinfo->values[k][q] = str[i+q];
-        }
-        k++;
-        i += 3;
-    }
-    LOG_MESSAGE("Allocated %d tuples.\n", tinfo->total_blocks);
+    // Tuples at positions mod 3 = 1 come first followed by mod 3 = 2
+    tuple_job job = {tinfo, t, (t->len + extra_block + 1) / 3};
+    parallel_run(fill_tuples_task, &job, parallel_chunks(tinfo->total_blocks));
+
+    LOG_MESSAGE("Created %" PRIdx " tuples.\n", tinfo->total_blocks);
     return tinfo;
 }
 
+/**
+* @brief The number of tuples at positions mod 3 = 1, 2 (with the extra block).
+**/
+idx_t tuple_blocks(idx_t str_len) {
+    idx_t extra_block = str_len % 3 == 1;
+    return (str_len - (str_len + 2)/3) + extra_block;
+}
+
+struct t0_job {
+    tuple_info *tinfo12;
+    tuple_info *tinfo0;
+    const text *t;
+    idx_t start[MAX_THREADS];
+};
+typedef struct t0_job t0_job;
+
+static void count_t0_task(void *arg, int id, int chunks) {
+    t0_job *job = arg;
+    idx_t end = chunk_begin(job->tinfo12->total_blocks, id+1, chunks);
+    idx_t count = 0;
+
+    for (idx_t i = chunk_begin(job->tinfo12->total_blocks, id, chunks); i < end; i++) {
+        count += job->tinfo12->tuple_type[i] == 1;
+    }
+    job->start[id] = count;
+}
+
+static void fill_t0_task(void *arg, int id, int chunks) {
+    t0_job *job = arg;
+    idx_t begin = chunk_begin(job->tinfo12->total_blocks, id, chunks);
+    idx_t end = chunk_begin(job->tinfo12->total_blocks, id+1, chunks);
+
+    TEXT_DISPATCH(job->t, fill_t0, job->tinfo0, job->tinfo12, job->start[id], begin, end);
+}
+
 /**
 * @brief Creates the tuple info structure for str on positions divisible by 3.
 *
@@ -100,30 +177,30 @@ tuple_info *str_to_tuples(int *str, int str_len) {
 * just need to sort according to the added letters which 
 * requires just one pass of the radix algorithm. 
 *
+* @param[out] tinfo0 The positions and values arrays must hold (str_len+2)/3 entries.
 * @param[in] tinfo12 Should hold information about SA12 to this point
-* @param[in] str The input string.
-* @param[in] str_len The input string length.
+* @param[in] t The input text.
 *
 **/
-tuple_info *create_t0_ordered(tuple_info *tinfo12, int *str, int str_len) {
+tuple_info *create_t0_ordered(tuple_info *tinfo0, tuple_info *tinfo12, const text *t) {
     LOG_MESSAGE("Creating t0\n");
-    tuple_info *tinfo0 = malloc(sizeof(tuple_info));
-
-    tinfo0->total_blocks = (str_len+2)/3;
-    tinfo0->positions = malloc(tinfo0->total_blocks * sizeof(int));
-    tinfo0->values = malloc(tinfo0->total_blocks * sizeof(*tinfo0->values));
+    tinfo0->total_blocks = (t->len+2)/3;
+    tinfo0->key_range = t->alphabet + 1;
 
-    tinfo0->tuple_type = NULL;
-    tinfo0->tuple_sorting = NULL;
+    t0_job job = {tinfo12, tinfo0, t, {0}};
+    int chunks = parallel_chunks(tinfo12->total_blocks);
 
-    int k = 0;
-    for (int i = 0; i < tinfo12->total_blocks; i++) {
-        int pos = tinfo12->positions[i];
-        if (tinfo12->tuple_type[i] == 1) {
-            tinfo0->positions[k] = pos - 1;
-            tinfo0->values[k++][TUPLE_SIZE-1] = str[pos - 1];
+    // Every chunk needs to know where its first t0 entry goes
+    if (chunks > 1) {
+        parallel_run(count_t0_task, &job, chunks);
+        idx_t k = 0;
+        for (int t = 0; t < chunks; t++) {
+            idx_t tmp = job.start[t];
+            job.start[t] = k;
+            k += tmp;
         }
     }
+    parallel_run(fill_t0_task, &job, chunks);
     
     LOG_MESSAGE("t0 created\n");
     return tinfo0;
@@ -138,19 +215,11 @@ tuple_info *create_t0_ordered(tuple_info *tinfo12, int *str, int str_len) {
 *
 * @return Returns k where k <= 0 if t1 <= t2 else k > 0.
 **/
-int compare_tuples(int *t1, int *t2, int len) {
-    for (int i = 0; i < len; i++) {
+int compare_tuples(idx_t *t1, idx_t *t2, idx_t len) {
+    for (idx_t i = 0; i < len; i++) {
         if (t1[i] != t2[i]) {
-            return t1[i] - t2[i];
+            return t1[i] < t2[i] ? -1 : 1;
         }
     }
     return 0;
 }
-
-void cleanup_tinfo(tuple_info *tinfo) {
-    free(tinfo->values);
-    free(tinfo->positions);
-    free(tinfo->tuple_type);
-    free(tinfo->tuple_sorting);
-    free(tinfo);
-}
@@ -1,13 +1,13 @@
 #include "constants.h"
+#include "text.h"
 
 #ifndef TUPLE_H
 #define TUPLE_H
 
-int *name_tuples(tuple_info *tinfo);
-void cleanup_tinfo(tuple_info *tinfo);
-int compare_tuples(int *t1, int *t2, int len);
-tuple_info *str_to_tuples(int *str, int str_len);
-tuple_info *create_t0(tuple_info *tinfo12, int *str, int str_len);
-tuple_info *create_t0_ordered(tuple_info *tinfo12, int *str, int str_len);
+idx_t tuple_blocks(idx_t str_len);
+idx_t *name_tuples(tuple_info *tinfo, idx_t *tuple_names);
+int compare_tuples(idx_t *t1, idx_t *t2, idx_t len);
+tuple_info *str_to_tuples(tuple_info *tinfo, const text *t);
+tuple_info *create_t0_ordered(tuple_info *tinfo0, tuple_info *tinfo12, const text *t);
 
 #endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "constants.h"
+#include "text.h"
 #include "util.h"
 
 #include <stdlib.h>
@@ -7,54 +8,64 @@
 #include <ctype.h>
 #include <time.h>
 
-// Used for printing purposes
-int find_prev(int *str, int i, int k) {
-    for (int j = i-1; j >= 0; j--) {
-        if (!memcmp(str+j, str+i, k * sizeof(int))) {
-            return j;
-        }
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Prints val as a character if it is printable ascii, as a number otherwise
+static void print_symbol(idx_t val, char *char_fmt, char *num_fmt) {
+    if (val >= 0 && val < 128 && isprint((int)val)) {
+        printf(char_fmt, (int)val);
+    } else {
+        printf(num_fmt, val);
     }
-    return 0;
 }
 
-void print_lpf_array(int *str, int *lpf, int len) {
-    int j, k; 
+// Prints the text split around t[i...i+k-1]
+static void print_split(const text *t, idx_t i, idx_t k, char *delim) {
+    print_text(t, 0, i, " ");
+    print_text(t, i, k, " ");
+    print_text(t, i+k, t->len - i - k, delim);
+}
 
-    for (int i = 0; i < len; i++) {
-        k = lpf[i];
-        printf("LPF[%d] = %d\t", i, lpf[i]);
-        
-        if (k > 0) {
-            printf_line(str, i, " ");
-            printf_line(str+i, k, " ");
-            printf_line(str+i+k, len - i - k, "\t");
+/**
+* @brief Print every factor next to its previous occurrence.
+*
+* @param[in] t The text.
+* @param[in] lpf The LPF array.
+* @param[in] prev_occ The previous occurrences (see lpf_array_prev), NULL to print only the factors.
+**/
+void print_lpf_array(const text *t, idx_t *lpf, idx_t *prev_occ) {
+    idx_t k; 
 
-            j = find_prev(str, i, k);
+    for (idx_t i = 0; i < t->len; i++) {
+        k = lpf[i];
+        printf("LPF[%" PRIdx "] = %" PRIdx "\t", i, lpf[i]);
         
-            printf_line(str, j, " ");
-            printf_line(str+j, k, " ");
-            printf_line(str+j+k, len - j - k, "\n");
+        if (k > 0 && prev_occ != NULL) {
+            print_split(t, i, k, "\t");
+            print_split(t, prev_occ[i], k, "\n");
+        } else if (k > 0) {
+            print_split(t, i, k, "\n");
         } else {
-            printf_line(str, i, " ");
-            printf_line(str+i, 1, " ");
-            printf_line(str+i+1, len - i - 1, "\n");
+            print_split(t, i, 1, "\n");
         }
     }
 }
 
 void print_tuple_info(tuple_info *tinfo) {
-    int *tmp = malloc(sizeof(int) * tinfo->total_blocks);
-    for (int i = 0; i < tinfo->total_blocks; i++) {
+    idx_t *tmp = malloc(sizeof(idx_t) * tinfo->total_blocks);
+    for (idx_t i = 0; i < tinfo->total_blocks; i++) {
         tmp[tinfo->tuple_sorting[i]] = i;
     }
     
-    printf("TUPLES:\nNumber of all blocks: %d\nPOS\t|\tTYPE\t|\tSORTING\t|\tVALUES\n", tinfo->total_blocks);
-    for (int i=0; i < tinfo->total_blocks; i++) {
-        printf("%d\t|\t%d\t|\t%d\t|\t%d\t|\t", tinfo->positions[i], tinfo->tuple_type[i], tinfo->tuple_sorting[i], tmp[i]);
+    printf("TUPLES:\nNumber of all blocks: %" PRIdx "\nPOS\t|\tTYPE\t|\tSORTING\t|\tVALUES\n", tinfo->total_blocks);
+    for (idx_t i=0; i < tinfo->total_blocks; i++) {
+        printf("%" PRIdx "\t|\t%" PRIdx "\t|\t%" PRIdx "\t|\t%" PRIdx "\t|\t", tinfo->positions[i], tinfo->tuple_type[i], tinfo->tuple_sorting[i], tmp[i]);
 
-        for (int j=0; j < TUPLE_SIZE; j++) {
-            int val = tinfo->values[i][j];
-            printf(isprint(val) ? "%c " : "'%d' ", val);
+        for (int j=0; j < TUPLE_SIZE && tinfo->values != NULL; j++) {
+            idx_t val = tinfo->values[i][j];
+            print_symbol(val, "%c ", "'%" PRIdx "' ");
             // printf("%d ", val);
         }
         printf("\n");
@@ -62,38 +73,46 @@ void print_tuple_info(tuple_info *tinfo) {
     free(tmp);
 }
 
-void print_sa_from_tinfo(int *str, int str_len, tuple_info *tinfo, char *title) {
+void print_sa_from_tinfo(const text *t, tuple_info *tinfo, char *title) {
     printf("\n%s\n", title);
     printf("Sorting: ");
-    for (int i = 0; i < tinfo->total_blocks; i++) {
-        printf("%d ", tinfo->tuple_sorting[i]);
+    for (idx_t i = 0; i < tinfo->total_blocks; i++) {
+        printf("%" PRIdx " ", tinfo->tuple_sorting[i]);
     } 
     printf("\n");
-    for (int i = 0; i < tinfo->total_blocks; i++) {
-        int pos = tinfo->positions[i];
-        printf("%d ", pos);
-        printf_array(str+pos, str_len-pos);
-        printf("\n");
+    for (idx_t i = 0; i < tinfo->total_blocks; i++) {
+        idx_t pos = tinfo->positions[i];
+        printf("%" PRIdx " ", pos);
+        print_text(t, pos, t->len-pos, "\n");
     }
     printf("\n");
 }  
 
-void printf_array(int *str, int str_len) {
+void printf_array(idx_t *str, idx_t str_len) {
     printf("[");
-    for (int i = 0; i < str_len-1; i++) {
-        int val = str[i];
+    for (idx_t i = 0; i < str_len-1; i++) {
+        idx_t val = str[i];
         // printf("%d, ", val);
-        printf(isprint(val) ? "%c " : "%d ", val);
+        print_symbol(val, "%c ", "%" PRIdx " ");
         // printf("%d, ", val);
     }
-    printf(isprint(str[str_len-1]) ? "%c]" : "%d]", str[str_len-1]);
+    print_symbol(str[str_len-1], "%c]", "%" PRIdx "]");
     printf("\n");
 }
 
-void printf_line(int *str, int str_len, char *delim) {
-    for (int i = 0; i < str_len; i++) {
-        int val = str[i];
-        printf(isprint(val) ? "%c" : "[%d]", val);
+// Prints the values of an index array (SA, LCP, LPF) as numbers
+void print_index_array(idx_t *arr, idx_t len) {
+    printf("[");
+    for (idx_t i = 0; i < len; i++) {
+        printf(i + 1 < len ? "%" PRIdx " " : "%" PRIdx, arr[i]);
+    }
+    printf("]\n");
+}
+
+void printf_line(idx_t *str, idx_t str_len, char *delim) {
+    for (idx_t i = 0; i < str_len; i++) {
+        idx_t val = str[i];
+        print_symbol(val, "%c", "[%" PRIdx "]");
     }
     if (delim == NULL) {
         printf("\n");
@@ -102,20 +121,52 @@ void printf_line(int *str, int str_len, char *delim) {
     }
 }
 
-int *random_str(int *str, int str_len, int asize) {
-    if (str == NULL) {
-        str = malloc((str_len + ADDITIONAL_PADDING) * sizeof(int));
+// Prints t[from...from+len-1]
+void print_text(const text *t, idx_t from, idx_t len, char *delim) {
+    for (idx_t i = 0; i < len; i++) {
+        print_symbol(text_symbol(t, from + i), "%c", "[%" PRIdx "]");
     }
- 
-    srand((unsigned int)time(NULL));
+    if (delim == NULL) {
+        printf("\n");
+    } else {
+        printf("%s", delim);
+    }
+}
 
-    for (int i = 0; i < str_len; i++) {
-        str[i] = (rand() % asize) + 97;
+/**
+* @brief Create a random text over the letters [97, 97 + asize).
+*
+* The symbols are stored in the narrowest type which holds the
+* alphabet, so for asize <= 159 the text is a byte string.
+* The letters come from rand(), seed it with srand for a reproducible text.
+*
+* @param[in] str Buffer of str_len symbols of that type (NULL to allocate it).
+* @param[in] str_len The text length.
+* @param[in] asize The alphabet size.
+*
+* @return Returns the text, its symbols point to the buffer.
+**/
+text random_text(void *str, idx_t str_len, int asize) {
+    SymbolType type = symbol_type_for(97 + asize);
+    if (str == NULL) {
+        str = malloc((str_len > 0 ? str_len : 1) * symbol_size(type));
     }
-    for (int j = str_len; j < str_len + ADDITIONAL_PADDING; j++) {
-        str[j] = 0;
+
+    for (idx_t i = 0; i < str_len; i++) {
+        idx_t sym = (rand() % asize) + 97;
+        switch (type) {
+            case SYM_U8:
+                ((uint8_t *)str)[i] = (uint8_t)sym;
+                break;
+            case SYM_U16:
+                ((uint16_t *)str)[i] = (uint16_t)sym;
+                break;
+            default:
+                ((uint32_t *)str)[i] = (uint32_t)sym;
+                break;
+        }
     }
-    return str;
+    return text_init(str, str_len, type, 97 + asize);
 }
 
 int file_has_line(char *filename) {
@@ -179,7 +230,7 @@ data_frame *create_data_frame(int datapoints, char *filename, char *header) {
     return data;
 }
 
-int fibonacci(int n) {
+idx_t fibonacci(int n) {
     unsigned long long a = 1, b = 2, next;
 
     for (int i = 0; i < n; i++) {
@@ -190,9 +241,9 @@ int fibonacci(int n) {
     return a;
 }
 
-int *fib_str(int *str, int n) {
+uint8_t *fib_str(uint8_t *str, int n) {
     if (str == NULL) {
-        str = calloc(fibonacci(n) + ADDITIONAL_PADDING, sizeof(int));
+        str = calloc(fibonacci(n), sizeof(uint8_t));
     }
     str[0] = 'a';
     
@@ -202,13 +253,36 @@ int *fib_str(int *str, int n) {
         return str;
     }
 
-    int prev, curr_len;
+    idx_t prev, curr_len;
     for (int i = 2; i <= n; i++) {
         prev = fibonacci(i-2);
         curr_len = fibonacci(i-1);
-        memcpy(str+curr_len, str, prev * sizeof(int));
+        memcpy(str+curr_len, str, prev * sizeof(uint8_t));
     }
 
     return str;
 } 
 
+/**
+* @brief A cycle counter for timing short kernels.
+*
+* The time stamp counter on x86, nanoseconds of the monotonic clock elsewhere.
+**/
+uint64_t cycle_count() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/**
+* @brief Wall-clock seconds of the monotonic clock, for elapsed times.
+**/
+double wall_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
@@ -1,19 +1,24 @@
 #include "constants.h"
+#include "text.h"
 #include <stdio.h>
 
 #ifndef UTIL_H
 #define UTIL_H
 
-void print_sa_from_tinfo(int *str, int str_len, tuple_info *tinfo, char *title);
-void printf_line(int *str, int str_len, char *delim);
-void print_lpf_array(int *str, int *lpf, int len);
+void print_sa_from_tinfo(const text *t, tuple_info *tinfo, char *title);
+void printf_line(idx_t *str, idx_t str_len, char *delim);
+void print_text(const text *t, idx_t from, idx_t len, char *delim);
+void print_lpf_array(const text *t, idx_t *lpf, idx_t *prev_occ);
 void print_tuple_info(tuple_info *tinfo);
-void printf_array(int *str, int str_len);
+void printf_array(idx_t *str, idx_t str_len);
+void print_index_array(idx_t *arr, idx_t len);
 void write_to_csv(data_frame *data, FILE *file);
 void cleanup_data(data_frame *data);
-int *random_str(int *str, int str_len, int asize);
-int *fib_str(int *str, int n);
-int fibonacci(int n);
+text random_text(void *str, idx_t str_len, int asize);
+uint8_t *fib_str(uint8_t *str, int n);
+idx_t fibonacci(int n);
+uint64_t cycle_count();
+double wall_time();
 data_frame *create_data_frame(int datapoints, char *filename, char *header);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "workspace.h"
+#include "phase.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/**
+* @brief Create a workspace arena.
+*
+* The workspace is a stack allocator: every temporary array of the
+* SA -> LCP -> LPF pipeline is carved from one buffer and given back
+* with ws_release in reverse order. The buffer is allocated once
+* and reused for every call so no heap allocations happen in steady state.
+*
+* @param[in] size Initial size in bytes (use the *_workspace_size functions, 0 to defer).
+*
+* @return Returns a pointer to the workspace.
+**/
+workspace *create_workspace(size_t size) {
+    workspace *ws = malloc(sizeof(workspace));
+    if (ws == NULL) {
+        perror("Error allocating workspace");
+        exit(1);
+    }
+    ws->buffer = NULL;
+    ws->size = 0;
+    ws->used = 0;
+    ws->peak = 0;
+    ws->allocations = 0;
+    ensure_workspace(ws, size);
+    return ws;
+}
+
+void cleanup_workspace(workspace *ws) {
+    if (ws == NULL) {
+        return;
+    }
+    free(ws->buffer);
+    free(ws);
+}
+
+/**
+* @brief Make sure that at least size bytes are free in the workspace.
+*
+* An idle workspace (nothing allocated) is grown if it is too small,
+* this is the only place where the workspace touches the heap.
+* A workspace which is in use can not move, so a nested call must
+* already fit into the remaining space.
+*
+* @param[in,out] ws The workspace.
+* @param[in] size Number of bytes needed.
+**/
+void ensure_workspace(workspace *ws, size_t size) {
+    if (ws->size - ws->used >= size) {
+        return;
+    }
+    if (ws->used > 0) {
+        fprintf(stderr, "Workspace too small: %zu bytes free, %zu bytes needed\n", ws->size - ws->used, size);
+        abort();
+    }
+
+    free(ws->buffer);
+    ws->buffer = aligned_alloc(WORKSPACE_ALIGNMENT, WS_SIZE(size));
+    if (ws->buffer == NULL) {
+        perror("Error allocating workspace");
+        exit(1);
+    }
+    ws->size = WS_SIZE(size);
+    ws->allocations++;
+}
+
+/**
+* @brief Allocate bytes from the workspace.
+*
+* Every allocation is aligned to WORKSPACE_ALIGNMENT so its cost
+* in the size estimates is WS_SIZE(bytes).
+*
+* @return Returns a pointer to the (uninitialized) memory.
+**/
+void *ws_alloc(workspace *ws, size_t bytes) {
+    size_t size = WS_SIZE(bytes);
+
+    if (ws->size - ws->used < size) {
+        fprintf(stderr, "Workspace exhausted: %zu of %zu bytes used, %zu bytes requested\n", ws->used, ws->size, bytes);
+        abort();
+    }
+
+    void *ptr = ws->buffer + ws->used;
+    ws->used += size;
+    if (ws->used > ws->peak) {
+        ws->peak = ws->used;
+    }
+    phase_memory((long long)size);
+    return ptr;
+}
+
+void *ws_calloc(workspace *ws, size_t bytes) {
+    void *ptr = ws_alloc(ws, bytes);
+    memset(ptr, 0, bytes);
+    return ptr;
+}
+
+/**
+* @brief The current top of the workspace, pass it to ws_release to free
+* everything allocated after this call.
+**/
+size_t ws_mark(workspace *ws) {
+    return ws->used;
+}
+
+void ws_release(workspace *ws, size_t mark) {
+    phase_memory(-(long long)(ws->used - mark));
+    ws->used = mark;
+}
+
+/**
+* @brief Allocate an array outside of a workspace (a result or a
+* temporary of a function without one) and account it in the phases.
+*
+* The memory is freed with mem_free and the same size, or with free
+* by the caller which received it, then it stays counted until
+* reset_phase_stats.
+*
+* @return Returns a pointer to the (uninitialized) memory, at least 1 byte.
+**/
+void *mem_alloc(size_t bytes) {
+    void *ptr = malloc(bytes > 0 ? bytes : 1);
+    if (ptr == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    phase_memory((long long)bytes);
+    return ptr;
+}
+
+void *mem_calloc(size_t count, size_t size) {
+    void *ptr = calloc(count > 0 ? count : 1, size);
+    if (ptr == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    phase_memory((long long)(count * size));
+    return ptr;
+}
+
+/**
+* @brief Resize memory of mem_alloc from old_bytes to bytes, keeping its content.
+*
+* Large blocks are remapped by the C library instead of copied, arrays
+* which grow by doubling do not pause for a copy of all of their content.
+**/
+void *mem_realloc(void *ptr, size_t old_bytes, size_t bytes) {
+    void *next = realloc(ptr, bytes > 0 ? bytes : 1);
+    if (next == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    phase_memory((long long)bytes - (long long)old_bytes);
+    return next;
+}
+
+void mem_free(void *ptr, size_t bytes) {
+    if (ptr == NULL) {
+        return;
+    }
+    phase_memory(-(long long)bytes);
+    free(ptr);
+}
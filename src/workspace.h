@@ -0,0 +1,30 @@
+#include <stddef.h>
+
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#define WORKSPACE_ALIGNMENT 64
+#define WS_SIZE(bytes) ((((size_t)(bytes)) + WORKSPACE_ALIGNMENT - 1) & ~(size_t)(WORKSPACE_ALIGNMENT - 1))
+
+struct workspace {
+    char *buffer;
+    size_t size;
+    size_t used;
+    size_t peak;
+    long long allocations;
+};
+typedef struct workspace workspace;
+
+workspace *create_workspace(size_t size);
+void cleanup_workspace(workspace *ws);
+void ensure_workspace(workspace *ws, size_t size);
+void *ws_alloc(workspace *ws, size_t bytes);
+void *ws_calloc(workspace *ws, size_t bytes);
+size_t ws_mark(workspace *ws);
+void ws_release(workspace *ws, size_t mark);
+void *mem_alloc(size_t bytes);
+void *mem_calloc(size_t count, size_t size);
+void *mem_realloc(void *ptr, size_t old_bytes, size_t bytes);
+void mem_free(void *ptr, size_t bytes);
+
+#endif